@@ -6,15 +6,23 @@
 #pragma once
 #include <pthread.h>
 #include <stdexcept>
+#include <string>
 
 /**
  * @class ThreadGroup - wrapper around pthread library for a group of threads
- * 
+ *
  * Using the ThreadGroup allows us to:
  * a) keep track of all the threads we started so we can wait for them together
  * b) not use global variables since we pass in one shared memory pointer to all
  *    the threads as an argument
  *
+ * A ThreadGroup runs in one of two modes:
+ * - thread-per-call (default constructor): every createThread starts a new pthread
+ *   and waitForAll joins them.
+ * - pooled (ThreadGroup(nWorkers)): nWorkers pthreads are started once and parked;
+ *   createThread hands the task to a parked worker and waitForAll is just a
+ *   completion barrier. The workers are joined when the group is destroyed.
+ *
  * @tparam P - process class: this has just ()-operator overloaded with the thread
  *             routine. Arguments to the ()-operator are int id, void *sharedData
  */
@@ -27,11 +35,20 @@ private:
 		int id;
 		void *sharedData;
 
-		Node(int id, void *sharedData, Node *next) 
+		Node(int id, void *sharedData, Node *next)
 			: next(next), thread(0), id(id), sharedData(sharedData) {
 		}
 	};
-	Node *head;
+	Node *head;          // running threads (thread-per-call) or queued tasks (pooled)
+	Node *tail;          // last queued task (pooled only)
+	Node *spare;         // recycled task nodes so dispatch does not allocate (pooled only)
+	pthread_t *workers;  // parked worker threads (pooled only)
+	int nWorkers;
+	int pending;         // tasks queued or still running (pooled only)
+	bool stopping;
+	pthread_mutex_t lock;
+	pthread_cond_t workReady;
+	pthread_cond_t allDone;
 
 	static void* startThread(void* arg) {
 		Node* node = (Node*)arg;
@@ -40,29 +57,134 @@ private:
 		return nullptr;
 	}
 
+	static void* startWorker(void* arg) {
+		((ThreadGroup<P>*)arg)->workLoop();
+		return nullptr;
+	}
+
+	/**
+	 * Body of each pooled worker: park until a task is queued, run it, and
+	 * signal the completion barrier when the last pending task finishes.
+	 */
+	void workLoop() {
+		pthread_mutex_lock(&lock);
+		while (true) {
+			while (head == nullptr && !stopping)
+				pthread_cond_wait(&workReady, &lock);
+			if (head == nullptr)
+				break;  // stopping and nothing left to do
+			Node *task = head;
+			head = head->next;
+			if (head == nullptr)
+				tail = nullptr;
+			pthread_mutex_unlock(&lock);
+
+			P proc;
+			proc(task->id, task->sharedData);
+
+			pthread_mutex_lock(&lock);
+			task->next = spare;
+			spare = task;
+			if (--pending == 0)
+				pthread_cond_broadcast(&allDone);
+		}
+		pthread_mutex_unlock(&lock);
+	}
+
+	static void deleteList(Node *list) {
+		while (list != nullptr) {
+			Node *done = list;
+			list = list->next;
+			delete done;
+		}
+	}
+
+	/**
+	 * Finishes any queued tasks, then wakes and joins the pooled workers.
+	 */
+	void shutdown() {
+		pthread_mutex_lock(&lock);
+		stopping = true;
+		pthread_cond_broadcast(&workReady);
+		pthread_mutex_unlock(&lock);
+		for (int i = 0; i < nWorkers; i++)
+			pthread_join(workers[i], nullptr);
+		delete[] workers;
+		workers = nullptr;
+		deleteList(spare);
+		spare = nullptr;
+		pthread_cond_destroy(&allDone);
+		pthread_cond_destroy(&workReady);
+		pthread_mutex_destroy(&lock);
+	}
+
 public:
-	ThreadGroup() : head(nullptr) {
+	ThreadGroup() : head(nullptr), tail(nullptr), spare(nullptr), workers(nullptr),
+			nWorkers(0), pending(0), stopping(false) {
 	}
+
+	/**
+	 * Creates a pooled group with nWorkers persistent threads parked until
+	 * tasks are handed to them with createThread.
+	 *
+	 * @param nWorkers - number of worker threads to start (must be > 0)
+	 */
+	explicit ThreadGroup(int nWorkers) : ThreadGroup() {
+		if (nWorkers <= 0)
+			throw std::invalid_argument("pool needs at least one worker");
+		pthread_mutex_init(&lock, nullptr);
+		pthread_cond_init(&workReady, nullptr);
+		pthread_cond_init(&allDone, nullptr);
+		workers = new pthread_t[nWorkers];
+		for (; this->nWorkers < nWorkers; this->nWorkers++)
+			if (0 != pthread_create(&workers[this->nWorkers], nullptr,
+					&ThreadGroup<P>::startWorker, this)) {
+				shutdown();
+				throw std::runtime_error("could not create worker " + std::to_string(this->nWorkers));
+			}
+	}
+
     ~ThreadGroup() {
-        while (head != nullptr) {
-            Node *done = head;
-            head = head->next;
-            delete done;
-        }
+        if (workers != nullptr)
+            shutdown();
+        deleteList(head);
     }
     ThreadGroup(const ThreadGroup<P>& other) = delete;
     ThreadGroup& operator=(const ThreadGroup<P>&) = delete;
 
 	/**
-	 * Creates a new thread in the group.
+	 * Creates a new thread in the group, or, for a pooled group, hands the
+	 * task to one of the parked workers.
 	 *
 	 * NOTE: Since each thread has it's own stack that is a fixed size, many threads
 	 * will eventually consume all the memory. Maximum number of threads is thus
-	 * a few hundred with default stack size.
+	 * a few hundred with default stack size. (This does not apply to pooled
+	 * groups, which queue any number of tasks for their fixed set of workers.)
 	 *
 	 * @param id  - thread number
 	 */
 	void createThread(int id, void *sharedData) {
+		if (workers != nullptr) {
+			pthread_mutex_lock(&lock);
+			Node *task = spare;
+			if (task != nullptr) {
+				spare = spare->next;
+				task->id = id;
+				task->sharedData = sharedData;
+				task->next = nullptr;
+			} else {
+				task = new Node(id, sharedData, nullptr);
+			}
+			if (tail == nullptr)
+				head = task;
+			else
+				tail->next = task;
+			tail = task;
+			pending++;
+			pthread_cond_signal(&workReady);
+			pthread_mutex_unlock(&lock);
+			return;
+		}
 		head = new Node(id, sharedData, head);
 		if (0 != pthread_create(&(head->thread), nullptr, &ThreadGroup<P>::startThread, head))
 			throw std::runtime_error("could not create thread " + std::to_string(id));
@@ -70,9 +192,17 @@ public:
 
 	/**
 	 * Waits for all the threads that have been created by createThread
-	 * to finish.
+	 * to finish. For a pooled group, waits for all dispatched tasks to
+	 * finish and leaves the workers parked for the next round.
 	 */
 	void waitForAll() {
+		if (workers != nullptr) {
+			pthread_mutex_lock(&lock);
+			while (pending > 0)
+				pthread_cond_wait(&allDone, &lock);
+			pthread_mutex_unlock(&lock);
+			return;
+		}
 		while (head != nullptr) {
 			pthread_join(head->thread, nullptr);
 			Node* done = head;
@@ -81,4 +211,3 @@ public:
 		}
 	}
 };
-
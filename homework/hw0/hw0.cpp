@@ -85,8 +85,12 @@ void prefixSums(int *data, int length) {
 	sharedData.length = length;
 	sharedData.data = data;
 
+	// Encoding and decoding workers are pooled: they are started on the first
+	// call, stay parked between calls, and are joined at program exit
+	static ThreadGroup<EncodeThread> encoders(2);
+	static ThreadGroup<DecodeThread> decoders(2);
+
 	// Encoding threads
-	ThreadGroup<EncodeThread> encoders;
 	encoders.createThread(0, &sharedData);
 	encoders.createThread(1, &sharedData);
 	encoders.waitForAll();
@@ -98,7 +102,6 @@ void prefixSums(int *data, int length) {
 	}
 
 	// Decoding threads
-	ThreadGroup<DecodeThread> decoders;
 	decoders.createThread(0, &sharedData);
 	decoders.createThread(1, &sharedData);
 	decoders.waitForAll();
@@ -0,0 +1,65 @@
+/**
+ * @file pool_bench.cpp - dispatch latency of pooled vs thread-per-call ThreadGroup
+ *
+ * Each round hands N_TASKS empty tasks to a group and waits for all of them,
+ * which is the pattern prefixSums in hw0.cpp follows twice per call. The
+ * thread-per-call group pays for pthread_create/pthread_join every round; the
+ * pooled group starts its workers once and only pays for the hand-off.
+ */
+#include <chrono>
+#include <iostream>
+#include "ThreadGroup.h"
+using namespace std;
+
+const int N_TASKS = 2;
+const int ROUNDS = 10000;
+
+/**
+ * @class NoopThread - task that does no work so that only dispatch is timed
+ */
+class NoopThread {
+public:
+	void operator()(int id, void *sharedData) {
+		((int*)sharedData)[id]++;
+	}
+};
+
+/**
+ * Time ROUNDS rounds of N_TASKS createThread calls followed by waitForAll.
+ *
+ * @param group  thread group to dispatch to
+ * @param counts per-task counters the tasks bump (one per task id)
+ * @return average microseconds per round
+ */
+double timeRounds(ThreadGroup<NoopThread> &group, int *counts) {
+	auto start = chrono::steady_clock::now();
+	for (int r = 0; r < ROUNDS; r++) {
+		for (int id = 0; id < N_TASKS; id++)
+			group.createThread(id, counts);
+		group.waitForAll();
+	}
+	auto end = chrono::steady_clock::now();
+	return chrono::duration<double,micro>(end - start).count() / ROUNDS;
+}
+
+int main() {
+	int counts[N_TASKS] = {};
+
+	ThreadGroup<NoopThread> perCall;
+	double perCallUs = timeRounds(perCall, counts);
+
+	ThreadGroup<NoopThread> pooled(N_TASKS);
+	double pooledUs = timeRounds(pooled, counts);
+
+	for (int id = 0; id < N_TASKS; id++)
+		if (counts[id] != 2 * ROUNDS) {
+			cout << "FAILED: task " << id << " ran " << counts[id] << " times" << endl;
+			return 1;
+		}
+
+	cout << N_TASKS << " tasks x " << ROUNDS << " rounds" << endl
+			<< "thread-per-call: " << perCallUs << " us/round" << endl
+			<< "pooled:          " << pooledUs << " us/round" << endl
+			<< "speedup:         " << perCallUs / pooledUs << "x" << endl;
+	return 0;
+}
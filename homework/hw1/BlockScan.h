@@ -0,0 +1,106 @@
+/**
+ * @file BlockScan.h
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Cache-blocked three-phase inclusive prefix sum with the SumHeap interface.
+ *
+ * The input is cut into fixed-size chunks that fit comfortably in a core's L2 cache:
+ *  1) Reduce (constructor): each chunk's total is computed in parallel.
+ *  2) Scan of totals (constructor): the few thousand chunk totals are turned into
+ *     per-chunk starting offsets in one serial pass.
+ *  3) Rescan (prefixSums): each chunk is scanned in parallel, seeded with its offset.
+ *
+ * Phases 1 and 3 stream through the data front to back with the SIMD kernels from
+ * ScanKernels.h. The only extra storage is one int per chunk, instead of the (n-1)
+ * interior nodes that SumHeap keeps.
+ */
+
+#pragma once
+#include <stdexcept>
+#include <vector>
+#include "ForkJoinPool.h"
+#include "ScanKernels.h"
+
+/**
+ * @class BlockScan
+ * @brief Drop-in alternative to SumHeap: construct on the data, then call prefixSums.
+ */
+class BlockScan {
+public:
+    /** @brief Elements per chunk (64 KiB of ints). */
+    static const int CHUNK = 16 * 1024;
+
+    /**
+     * @brief Run the reduce phase and scan the chunk totals.
+     * @param data Pointer to the input array (caller-owned; must outlive this object).
+     * @param pool Scheduler the chunk loops run on; defaults to the shared pool.
+     */
+    BlockScan(const std::vector<int>* data, ForkJoinPool& pool = ForkJoinPool::common())
+        : data(data), pool(pool), size(static_cast<int>(data->size())),
+          offsets((size + CHUNK - 1) / CHUNK) {
+        const int* in = data->data();
+        pool.invoke([&] {
+            pool.forEach(0, chunks(), [&](int c) {
+                offsets[c] = ScanKernels::reduce(in + begin(c), end(c) - begin(c));
+            });
+        });
+
+        // exclusive scan of the chunk totals gives each chunk's starting offset
+        int running = 0;
+        for (int& offset: offsets) {
+            const int total = offset;
+            offset = running;
+            running += total;
+        }
+    }
+
+    /**
+     * @brief Compute inclusive prefix sums into the provided output vector.
+     * @param output Pointer to caller-owned output array with at least as many
+     *               elements as the input.
+     */
+    void prefixSums(std::vector<int>* output) {
+        const int* in = data->data();
+        int* out = output->data();
+        pool.invoke([&] {
+            pool.forEach(0, chunks(), [&](int c) {
+                ScanKernels::inclusiveScan(in + begin(c), out + begin(c), end(c) - begin(c), offsets[c]);
+            });
+        });
+    }
+
+    /**
+     * @brief Overwrite the input with its inclusive prefix sums, without a second buffer.
+     * @param inout The array this scan was constructed on.
+     * @throws std::invalid_argument if inout is some other array
+     */
+    void prefixSumsInPlace(std::vector<int>& inout) {
+        if (&inout != data) {
+            throw std::invalid_argument("in-place scan must be given the array it was built on");
+        }
+        prefixSums(&inout);
+    }
+
+private:
+    /** @brief Pointer to the caller-owned input data. */
+    const std::vector<int>* data;
+    /** @brief Scheduler the chunk loops run on. */
+    ForkJoinPool& pool;
+    /** @brief Number of input elements. */
+    int size;
+    /** @brief offsets[c] is the sum of every element before chunk c. */
+    std::vector<int> offsets;
+
+    int chunks() const {
+        return static_cast<int>(offsets.size());
+    }
+
+    int begin(int c) const {
+        return c * CHUNK;
+    }
+
+    int end(int c) const {
+        return c == chunks() - 1 ? size : (c + 1) * CHUNK;
+    }
+};
@@ -0,0 +1,304 @@
+/**
+ * @file ForkJoinPool.h
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Work-stealing fork/join scheduler used by the prefix-sum tree passes.
+ *
+ * The pool owns one deque of forked tasks per worker. A worker forking a pair of
+ * subtrees pushes one half onto the back of its own deque and runs the other half
+ * itself; idle workers steal from the front of a victim's deque, which is where the
+ * oldest (and therefore largest) subtrees sit. At the join, the forking worker pops
+ * its task back if nobody took it; otherwise it keeps stealing other work until the
+ * thief finishes, so no worker blocks while there is work left in the pool.
+ *
+ * Worker threads are started once and parked when there is nothing to steal, so
+ * repeated scans pay for thread creation only once.
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class ForkJoinPool
+ * @brief Fixed set of workers with per-worker deques and random-victim stealing.
+ *
+ * The thread calling @ref invoke becomes worker 0 for the duration of the call,
+ * so a pool of size w starts only w - 1 threads and a pool of size 1 runs
+ * everything inline.
+ */
+class ForkJoinPool {
+public:
+    /**
+     * @brief Start a pool.
+     * @param workers Number of workers including the invoking thread; defaults to
+     *                every hardware thread on the machine.
+     */
+    explicit ForkJoinPool(int workers = static_cast<int>(std::thread::hardware_concurrency()))
+        : queues(workers < 1 ? 1 : workers) {
+        for (int id = 1; id < size(); id++) {
+            threads.emplace_back(&ForkJoinPool::workLoop, this, id);
+        }
+    }
+
+    /** @brief Wake and join all workers. */
+    ~ForkJoinPool() {
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t: threads) {
+            t.join();
+        }
+    }
+
+    ForkJoinPool(const ForkJoinPool&) = delete;
+    ForkJoinPool& operator=(const ForkJoinPool&) = delete;
+
+    /**
+     * @brief Process-wide pool sized to the machine, created on first use.
+     * @return The shared pool.
+     */
+    static ForkJoinPool& common() {
+        static ForkJoinPool pool;
+        return pool;
+    }
+
+    /** @brief Number of workers, including the invoking thread. */
+    int size() const {
+        return static_cast<int>(queues.size());
+    }
+
+    /**
+     * @brief Number of recursion levels a divide-and-conquer pass should fork so that
+     *        every worker gets a few tasks to balance with.
+     * @return 0 for a single worker, else ceil(log2(size())) + FORK_SLACK_LEVELS.
+     */
+    int defaultForkDepth() const {
+        if (size() <= 1) return 0;
+
+        int levels = 0;
+        while ((1 << levels) < size()) {
+            levels++;
+        }
+        return levels + FORK_SLACK_LEVELS;
+    }
+
+    /**
+     * @brief Run a root task on the pool and return once it (and everything it
+     *        forked) is finished.
+     *
+     * Calls from inside one of this pool's tasks just run f directly. Concurrent
+     * calls from outside the pool are serialized.
+     *
+     * @param f Callable with no arguments.
+     */
+    template <typename F>
+    void invoke(F&& f) {
+        if (current() >= 0) {
+            f();
+            return;
+        }
+        std::lock_guard<std::mutex> guard(invokeLock);
+        Worker previous = self;
+        self = Worker{this, 0};
+        f();
+        self = previous;
+    }
+
+    /**
+     * @brief Run left and right, potentially in parallel, and return when both are done.
+     *
+     * left is offered to thieves while the calling worker runs right. Neither
+     * callable may throw.
+     *
+     * @param left  Callable with no arguments, forked.
+     * @param right Callable with no arguments, run by the calling worker.
+     */
+    template <typename L, typename R>
+    void forkJoin(L&& left, R&& right) {
+        const int id = current();
+        if (id < 0) {
+            invoke([&] { forkJoin(left, right); });
+            return;
+        }
+
+        Task task(&ForkJoinPool::call<typename std::remove_reference<L>::type>, &left);
+        push(id, &task);
+        right();
+
+        if (popIfTop(id, &task)) {
+            left();
+            return;
+        }
+
+        // stolen: help with other work until the thief finishes our task
+        while (!task.done.load(std::memory_order_acquire)) {
+            if (!stealAndRun(id)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /**
+     * @brief Call f(i) for every i in [begin, end), splitting the range in halves
+     *        through forkJoin so idle workers can steal the larger pieces.
+     *
+     * @param begin First index.
+     * @param end   One past the last index.
+     * @param f     Callable taking an int index; must not throw.
+     */
+    template <typename F>
+    void forEach(int begin, int end, const F& f) {
+        if (end - begin <= 1) {
+            if (begin < end) {
+                f(begin);
+            }
+            return;
+        }
+        const int mid = begin + (end - begin) / 2;
+        forkJoin(
+            [&] { forEach(begin, mid, f); },
+            [&] { forEach(mid, end, f); }
+            );
+    }
+
+private:
+    /**
+     * @brief Extra levels forked beyond one task per worker, so that thieves can
+     *        even out subtrees that finish at different speeds (2^3 = 8 tasks per worker).
+     */
+    static const int FORK_SLACK_LEVELS = 3;
+
+    /** @brief A forked, type-erased callable living on the forking worker's stack. */
+    struct Task {
+        void (*run)(void*);
+        void* fn;
+        std::atomic<bool> done;
+
+        Task(void (*run)(void*), void* fn): run(run), fn(fn), done(false) {}
+    };
+
+    /** @brief One worker's deque; the owner uses the back, thieves the front. */
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task*> tasks;
+    };
+
+    /** @brief Which pool and slot the current thread is working for, if any. */
+    struct Worker {
+        ForkJoinPool* pool;
+        int id;
+    };
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> threads;
+    /** @brief Tasks sitting in any deque; parked workers sleep while this is 0. */
+    std::atomic<int> queued{0};
+    std::atomic<int> sleepers{0};
+    bool stopping = false;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::mutex invokeLock;
+
+    static thread_local Worker self;
+
+    template <typename F>
+    static void call(void* fn) {
+        (*static_cast<F*>(fn))();
+    }
+
+    /** @return This thread's worker id in this pool, or -1 if it is not one of ours. */
+    int current() const {
+        return self.pool == this ? self.id : -1;
+    }
+
+    void push(int id, Task* task) {
+        {
+            std::lock_guard<std::mutex> guard(queues[id].lock);
+            queues[id].tasks.push_back(task);
+        }
+        queued.fetch_add(1);
+        if (sleepers.load() > 0) {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            wake.notify_one();
+        }
+    }
+
+    /**
+     * @brief Pop task off the back of our deque if it is still there.
+     *
+     * Forks and joins nest, so anything pushed after task has already been joined;
+     * if task is not at the back then a thief has it.
+     */
+    bool popIfTop(int id, Task* task) {
+        std::lock_guard<std::mutex> guard(queues[id].lock);
+        std::deque<Task*>& tasks = queues[id].tasks;
+        if (tasks.empty() || tasks.back() != task) {
+            return false;
+        }
+        tasks.pop_back();
+        queued.fetch_sub(1);
+        return true;
+    }
+
+    /**
+     * @brief Try each other worker once, starting at a random victim, and run the
+     *        first task found.
+     * @return true if a task was run.
+     */
+    bool stealAndRun(int id) {
+        static thread_local std::minstd_rand random(std::random_device{}());
+        const int n = size();
+        const int start = static_cast<int>(random() % n);
+        for (int i = 0; i < n; i++) {
+            const int victim = (start + i) % n;
+            if (victim == id) {
+                continue;
+            }
+            Task* task = nullptr;
+            {
+                std::lock_guard<std::mutex> guard(queues[victim].lock);
+                std::deque<Task*>& tasks = queues[victim].tasks;
+                if (!tasks.empty()) {
+                    task = tasks.front();
+                    tasks.pop_front();
+                }
+            }
+            if (task != nullptr) {
+                queued.fetch_sub(1);
+                task->run(task->fn);
+                task->done.store(true, std::memory_order_release);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** @brief Body of worker threads 1..size()-1: steal, or park until something is queued. */
+    void workLoop(int id) {
+        self = Worker{this, id};
+        while (true) {
+            if (stealAndRun(id)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(sleepLock);
+            sleepers.fetch_add(1);
+            wake.wait(guard, [this] { return stopping || queued.load() > 0; });
+            sleepers.fetch_sub(1);
+            if (stopping) {
+                return;
+            }
+        }
+    }
+};
+
+inline thread_local ForkJoinPool::Worker ForkJoinPool::self{nullptr, -1};
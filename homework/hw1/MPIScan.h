@@ -0,0 +1,87 @@
+/**
+ * @file MPIScan.h
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Inclusive prefix sum of an array partitioned across MPI ranks.
+ *
+ * Each rank owns one contiguous piece of the global array, in rank order. A scan
+ * takes three steps:
+ *  1) every rank runs the threaded up-sweep (Scan, the SumHeap tree) on its own
+ *     piece, which yields the piece's total;
+ *  2) one MPI_Exscan over those totals gives every rank the sum of all pieces on
+ *     lower ranks;
+ *  3) every rank runs its down-sweep seeded with that offset, so the fix-up is
+ *     applied as the results are written instead of in another pass.
+ *
+ * The only communication is the single Exscan of one value per rank.
+ */
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <mpi.h>
+#include "ForkJoinPool.h"
+#include "Scan.h"
+
+/** @brief MPI datatype for the element types MPIScan supports. */
+template <typename T> MPI_Datatype mpiType();
+template <> inline MPI_Datatype mpiType<int>() { return MPI_INT; }
+template <> inline MPI_Datatype mpiType<long>() { return MPI_LONG; }
+template <> inline MPI_Datatype mpiType<long long>() { return MPI_LONG_LONG; }
+template <> inline MPI_Datatype mpiType<float>() { return MPI_FLOAT; }
+template <> inline MPI_Datatype mpiType<double>() { return MPI_DOUBLE; }
+
+/**
+ * @class MPIScan
+ * @brief Distributed inclusive prefix sum with the SumHeap interface.
+ *
+ * Every rank in comm constructs an MPIScan on its own piece and then calls
+ * prefixSums; both calls are collective.
+ *
+ * @tparam T Element type (int, long, long long, float or double).
+ */
+template <typename T>
+class MPIScan {
+public:
+    typedef std::vector<T> Data;
+
+    /**
+     * @brief Run the local up-sweep and exchange piece totals (collective).
+     * @param local This rank's piece of the global array (caller-owned).
+     * @param comm Communicator whose ranks hold the pieces, in order.
+     * @param pool Scheduler the local passes fork onto; defaults to the shared pool.
+     */
+    MPIScan(const Data* local, MPI_Comm comm = MPI_COMM_WORLD,
+            ForkJoinPool& pool = ForkJoinPool::common())
+        : heap(local, pool), offset(T()) {
+        int rank;
+        MPI_Comm_rank(comm, &rank);
+
+        const T localTotal = heap.total();
+        MPI_Exscan(&localTotal, &offset, 1, mpiType<T>(), MPI_SUM, comm);
+        // MPI leaves the Exscan result on rank 0 undefined
+        if (rank == 0) {
+            offset = T();
+        }
+    }
+
+    /**
+     * @brief Write this rank's piece of the global inclusive prefix sums.
+     * @param output Pointer to caller-owned output array, same size as the local piece.
+     */
+    void prefixSums(Data* output) {
+        heap.prefixSums(output, offset);
+    }
+
+    /** @return Sum of all pieces on lower ranks. */
+    T rankOffset() const {
+        return offset;
+    }
+
+private:
+    /** @brief Threaded heap-tree scan of this rank's piece. */
+    Scan<T, Plus<T>> heap;
+    /** @brief Sum of all pieces on lower ranks. */
+    T offset;
+};
@@ -0,0 +1,650 @@
+/**
+ * @file Scan.h
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Ladner–Fischer prefix scan over any element type and associative operator.
+ *
+ * Scan<T, Op> is the heap-shaped two-pass algorithm from hw1.cpp with the element
+ * type and the combining operator as template parameters:
+ *  1) Up-sweep (reduction): compute subtree totals for all interior nodes.
+ *  2) Down-sweep (distribution): propagate prefix offsets to produce inclusive scans.
+ *
+ * Op is a class with a static identity() and a const operator()(a, b). Nothing is
+ * virtual, so each instantiation compiles the operator straight into the tree walks.
+ * Op must be associative; it need not be commutative (left operands always come
+ * from earlier in the array).
+ *
+ * Non-power-of-two input sizes:
+ *  - Let the real input length be originalSize.
+ *  - Let n be the next power of two >= originalSize.
+ *  - Build the conceptual tree with n leaves and (n - 1) interior nodes.
+ *  - Treat leaf positions [originalSize, n) as Op::identity().
+ *  - When writing the output array, only write indices [0, originalSize) and ignore padded leaves.
+ *
+ * ImplicitScan<T, Op> is the low-memory alternative: its leaves are contiguous blocks
+ * of the input rather than single elements, so it stores only a few totals per worker
+ * instead of the (n-1) interior nodes, and it needs no padding.
+ */
+
+#pragma once
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "ForkJoinPool.h"
+#include "ScanKernels.h"
+
+/** @brief Addition; identity 0. */
+template <typename T>
+struct Plus {
+    static T identity() { return T(0); }
+    T operator()(const T& a, const T& b) const { return a + b; }
+};
+
+/** @brief Maximum; identity is the lowest representable value. */
+template <typename T>
+struct Max {
+    static T identity() { return std::numeric_limits<T>::lowest(); }
+    T operator()(const T& a, const T& b) const { return std::max(a, b); }
+};
+
+/** @brief Minimum; identity is the largest representable value. */
+template <typename T>
+struct Min {
+    static T identity() { return std::numeric_limits<T>::max(); }
+    T operator()(const T& a, const T& b) const { return std::min(a, b); }
+};
+
+/** @brief The map x -> a*x + b. */
+template <typename T>
+struct AffineMap {
+    T a;
+    T b;
+
+    T operator()(const T& x) const { return a * x + b; }
+};
+
+/**
+ * @brief Composition of affine maps in array order: f then g is x -> g(f(x)).
+ *
+ * A scan of maps (a[i], b[i]) gives, at position i, the map that runs the linear
+ * recurrence x[j+1] = a[j]*x[j] + b[j] from x[0] through step i.
+ */
+template <typename T>
+struct Compose {
+    static AffineMap<T> identity() { return AffineMap<T>{T(1), T(0)}; }
+    AffineMap<T> operator()(const AffineMap<T>& f, const AffineMap<T>& g) const {
+        return AffineMap<T>{g.a * f.a, g.a * f.b + g.b};
+    }
+};
+
+/**
+ * @class Heaper
+ * @brief Utility base class that maps a conceptual complete binary tree onto array indices.
+ *
+ * @tparam T Element type stored at leaves and interior nodes.
+ */
+template <typename T>
+class Heaper {
+public:
+    /** @brief Input/output container type for the scan. */
+    typedef std::vector<T> Data;
+
+    /**
+     * @brief Construct heap/tree helpers for the provided input.
+     *
+     * Computes @ref n as the next power of two >= input size and allocates interior storage
+     * for (n-1) subtree totals.
+     *
+     * @param data Pointer to the input array.
+     */
+    Heaper(const Data* data)
+        : originalSize(static_cast<int>(data->size())), n(nextPowerOf2(originalSize)),
+          data(data), interior(n - 1) {
+    }
+
+protected:
+    /**
+     * @brief Construct the tree for subclasses whose leaves do not come from a Data array.
+     *
+     * @ref data is left null; the subclass supplies leaf values itself.
+     *
+     * @param originalSize Number of real leaves.
+     */
+    explicit Heaper(int originalSize)
+        : originalSize(originalSize), n(nextPowerOf2(originalSize)),
+          data(nullptr), interior(n - 1) {
+    }
+
+    /** @brief Real input length. Only indices [0, originalSize) contain real data. */
+    int originalSize;
+    /** @brief Tree leaf count. This is the next power of two >= originalSize. */
+    int n;
+    /** @brief Pointer to the caller-owned input data (leaves). */
+    const Data* data;
+    /** @brief Storage for interior-node subtree totals; size is (n-1). */
+    Data interior;
+
+    /**
+     * @brief Total number of nodes in the conceptual tree (interior + leaves).
+     * @return (n-1) + n == 2n-1.
+     */
+    int size() const {
+        return n - 1 + n;
+    }
+
+    int parent(int i) const {
+        return (i - 1) / 2;
+    }
+
+    int left(int i) const {
+        return (2 * i) + 1;
+    }
+
+    int right(int i) const {
+        return (2 * i) + 2;
+    }
+
+    bool isLeaf(int i) const {
+        return right(i) >= size();
+    }
+
+    /**
+     * @brief Compute the smallest power of two >= n.
+     *
+     * Used to round an arbitrary input size up to a leaf count suitable for a complete
+     * binary tree.
+     *
+     * @param n Input size.
+     * @return Smallest power of two greater than or equal to n.
+     */
+    static int nextPowerOf2(int n) {
+        if (n <= 1) return 1;
+
+        int x = n - 1;
+        x |= x >> 1;
+        x |= x >> 2;
+        x |= x >> 4;
+        x |= x >> 8;
+        x |= x >> 16;
+        return x + 1;
+    }
+};
+
+/**
+ * @class Scan
+ * @brief Ladner–Fischer inclusive scan over the heap-shaped tree.
+ *
+ * Construction performs the up-sweep pass to fill interior subtree totals.
+ * The @ref prefixSums method performs the down-sweep pass to produce an
+ * inclusive scan array. Both passes fork their top levels onto a ForkJoinPool.
+ *
+ * @tparam T Element type.
+ * @tparam Op Associative operator with static identity().
+ */
+template <typename T, typename Op>
+class Scan: public Heaper<T> {
+public:
+    typedef typename Heaper<T>::Data Data;
+
+    /**
+     * @brief Construct the heap and compute all interior subtree totals (up-sweep).
+     * @param data Pointer to the input array (caller-owned).
+     * @param pool Scheduler both passes fork onto; defaults to the shared pool.
+     */
+    Scan(const Data* data, ForkJoinPool& pool = ForkJoinPool::common())
+        : Scan(data, pool, pool.defaultForkDepth()) {
+    }
+
+    /**
+     * @brief Construct the heap with an explicit fork depth.
+     * @param data Pointer to the input array (caller-owned).
+     * @param pool Scheduler both passes fork onto.
+     * @param forkDepth Number of tree levels that fork; levels below run serially.
+     */
+    Scan(const Data* data, ForkJoinPool& pool, int forkDepth)
+        : Heaper<T>(data), pool(pool), forkDepth(forkDepth) {
+        calcSum(0);
+    }
+
+    /**
+     * @brief Compute the inclusive scan into the provided output vector.
+     *
+     * Performs the down-sweep pass. For padded trees, only indices [0, originalSize)
+     * are written.
+     *
+     * @param output Pointer to caller-owned output array.
+     */
+    void prefixSums(Data* output) {
+        downSweep(output, true, Op::identity());
+    }
+
+    /**
+     * @brief Compute the inclusive scan of the input as if it were preceded by elements
+     *        totalling prior, i.e. output[k] = op(prior, data[0], ..., data[k]).
+     *
+     * Used when the input is one piece of a larger array (see MPIScan.h): the offset
+     * is applied during the down-sweep rather than in a separate pass.
+     *
+     * @param output Pointer to caller-owned output array.
+     * @param prior Total of everything before data[0].
+     */
+    void prefixSums(Data* output, const T& prior) {
+        downSweep(output, true, prior);
+    }
+
+    /**
+     * @brief Total of the whole input, available as soon as the up-sweep is done.
+     * @return op(data[0], ..., data[originalSize-1]), or Op::identity() if empty.
+     */
+    T total() const {
+        return value(0);
+    }
+
+    /**
+     * @brief Overwrite the input with its inclusive scan.
+     *
+     * No second buffer is needed: each leaf is read only by the write that replaces it,
+     * and interior totals are unchanged. Afterwards this object's leaves are the results,
+     * so no further scans may be taken from it.
+     *
+     * @param inout The array this scan was constructed on.
+     * @throws std::invalid_argument if inout is some other array
+     */
+    void prefixSumsInPlace(Data& inout) {
+        checkInPlace(inout);
+        downSweep(&inout, true, Op::identity());
+    }
+
+    /**
+     * @brief Compute the exclusive scan (output[k] combines elements [0, k)) into output.
+     * @param output Pointer to caller-owned output array.
+     */
+    void exclusivePrefixSums(Data* output) {
+        downSweep(output, false, Op::identity());
+    }
+
+    /**
+     * @brief Overwrite the input with its exclusive scan; see prefixSumsInPlace.
+     * @param inout The array this scan was constructed on.
+     * @throws std::invalid_argument if inout is some other array
+     */
+    void exclusivePrefixSumsInPlace(Data& inout) {
+        checkInPlace(inout);
+        downSweep(&inout, false, Op::identity());
+    }
+
+protected:
+    using Heaper<T>::originalSize;
+    using Heaper<T>::n;
+    using Heaper<T>::data;
+    using Heaper<T>::interior;
+    using Heaper<T>::left;
+    using Heaper<T>::right;
+    using Heaper<T>::isLeaf;
+
+    /** @brief Scheduler both passes fork onto. */
+    ForkJoinPool& pool;
+    /** @brief Tree levels [0, forkDepth) fork; deeper levels run in the calling worker. */
+    int forkDepth;
+    /** @brief The combining operator. */
+    Op op;
+
+    /**
+     * @brief Read the value associated with a tree node.
+     *
+     * For interior nodes, returns the computed subtree total stored in @ref interior.
+     * For leaf nodes, returns the corresponding input value when within bounds, otherwise
+     * returns Op::identity().
+     *
+     * @param i Node index in the heap layout.
+     * @return Node value (subtree total for interior nodes; input or identity for leaves).
+     */
+    T value(int i) const {
+        // for interior nodes
+        if (i < n - 1) {
+            return interior[i];
+        }
+
+        // for leaf nodes
+        const int k = i - (n - 1);
+        // if index < original size, return real data
+        if (k < originalSize) {
+            return (*data)[k];
+        }
+        // else return logical padding of identities
+        return Op::identity();
+    }
+
+private:
+    void checkInPlace(const Data& inout) const {
+        if (&inout != data) {
+            throw std::invalid_argument("in-place scan must be given the array it was built on");
+        }
+    }
+
+    void downSweep(Data* output, bool inclusive, const T& prior) {
+        pool.invoke([&] { calcPrefixSums(0, prior, 0, inclusive, output); });
+    }
+
+    /**
+     * @brief Entry point to recursively compute subtree totals for interior nodes.
+     *
+     * @param i Node index -- always starts at 0.
+     */
+    void calcSum(int i) {
+        pool.invoke([&] { calcSumHelper(i, 0); });
+    }
+
+    /**
+     * @brief Recursively compute subtree totals for interior nodes.
+     *
+     * With parallelism the top @ref forkDepth levels fork tasks onto the pool; this
+     * routine preserves the dependency that a parent total is computed only after both
+     * children are complete.
+     *
+     * @param i Node index.
+     * @param currLevel Node i's current level -- always starts at 0 for root node.
+     */
+    void calcSumHelper(int i, int currLevel) {
+        // base case
+        if (isLeaf(i)) {
+            return;
+        }
+
+        const int leftChild = left(i);
+        const int rightChild = right(i);
+
+        // for the first forkDepth levels, fork a task
+        if (currLevel < forkDepth) {
+            pool.forkJoin(
+                [&] { calcSumHelper(leftChild, currLevel + 1); },
+                [&] { calcSumHelper(rightChild, currLevel + 1); }
+                );
+        }
+        // for the lower levels, do it in the calling worker
+        else {
+            calcSumHelper(leftChild, currLevel + 1);
+            calcSumHelper(rightChild, currLevel + 1);
+        }
+
+        interior[i] = op(value(leftChild), value(rightChild));
+    }
+
+    /**
+     * @brief Recursively propagate prefix offsets and write scan results.
+     *
+     * The parameter prior represents the total of all elements strictly before the subtree
+     * rooted at node i. The left child inherits prior; the right child receives
+     * op(prior, total of left subtree).
+     *
+     * Base case writes the final scan value for a leaf into output[k], where
+     * k = i - (n-1), when k is within [0, originalSize): op(prior, leaf) for an
+     * inclusive scan, prior for an exclusive one.
+     *
+     * The left subtree's total is read before either child is visited, because when
+     * output is the input array the left child may be a leaf that is about to be
+     * overwritten.
+     *
+     * @param i Node index.
+     * @param prior Total of elements before this subtree.
+     * @param currLevel Node i's current level -- always starts at 0 for root node.
+     * @param inclusive Whether each output includes its own element.
+     * @param output Output array to fill.
+     */
+    void calcPrefixSums(int i, T prior, int currLevel, bool inclusive, Data* output) {
+        if (isLeaf(i)) {
+            const int k = i - (n - 1);
+
+            // if index k is within bounds of original input array, write to
+            // corresponding output array
+            if (k < originalSize) {
+                (*output)[k] = inclusive ? op(prior, value(i)) : prior;
+            }
+            return;
+        }
+
+        const int leftChild = left(i);
+        const int rightChild = right(i);
+        const T rightPrior = op(prior, value(leftChild));
+
+        // for the first forkDepth levels, fork a task
+        if (currLevel < forkDepth) {
+            pool.forkJoin(
+                [&] { calcPrefixSums(leftChild, prior, currLevel + 1, inclusive, output); },
+                [&] { calcPrefixSums(rightChild, rightPrior, currLevel + 1, inclusive, output); }
+                );
+        }
+        // for the lower levels, do it in the calling worker
+        else {
+            calcPrefixSums(leftChild, prior, currLevel + 1, inclusive, output);
+            calcPrefixSums(rightChild, rightPrior, currLevel + 1, inclusive, output);
+        }
+    }
+};
+
+/**
+ * @class ImplicitScan
+ * @brief Low-memory scan: the same two passes over a tree whose leaves are input blocks.
+ *
+ * The input is split into about LEAVES_PER_WORKER blocks per pool worker (but never
+ * blocks shorter than MIN_BLOCK). A block-level tree is walked by recursing on
+ * [lo, hi) ranges of block indices split at the midpoint, so the tree shape is
+ * implicit in the recursion and every leaf is a real block; a short last block needs
+ * no padding. Node totals are kept in pre-order: the node at i covering [lo, hi) has
+ * its left child at i + 1 and its right child at i + 2*(mid - lo), which uses exactly
+ * 2L-1 slots for L blocks.
+ *
+ *  1) Up-sweep (constructor): each leaf reduces its block; parents combine children.
+ *  2) Down-sweep (prefixSums): each leaf scans its block, seeded by the total of
+ *     everything before it.
+ *
+ * @tparam T Element type.
+ * @tparam Op Associative operator with static identity().
+ */
+template <typename T, typename Op>
+class ImplicitScan {
+public:
+    typedef std::vector<T> Data;
+
+    /** @brief Blocks per worker; enough for thieves to balance uneven progress. */
+    static const int LEAVES_PER_WORKER = 64;
+    /** @brief Shortest block worth a task of its own. */
+    static const int MIN_BLOCK = 4096;
+
+    /**
+     * @brief Choose the blocks and compute all block-tree totals (up-sweep).
+     * @param data Pointer to the input array (caller-owned).
+     * @param pool Scheduler both passes fork onto; defaults to the shared pool.
+     */
+    ImplicitScan(const Data* data, ForkJoinPool& pool = ForkJoinPool::common())
+        : data(data), pool(pool), size(static_cast<int>(data->size())),
+          blockSize(chooseBlockSize(size, pool.size())),
+          blocks(size == 0 ? 0 : (size + blockSize - 1) / blockSize),
+          totals(blocks == 0 ? 0 : 2 * blocks - 1) {
+        if (blocks > 0) {
+            pool.invoke([&] { calcSum(0, 0, blocks); });
+        }
+    }
+
+    /**
+     * @brief Compute the inclusive scan into the provided output vector.
+     * @param output Pointer to caller-owned output array with at least as many
+     *               elements as the input.
+     */
+    void prefixSums(Data* output) {
+        downSweep(output, true);
+    }
+
+    /**
+     * @brief Overwrite the input with its inclusive scan, without a second buffer.
+     *
+     * Afterwards this object's blocks hold the results, so no further scans may be
+     * taken from it.
+     *
+     * @param inout The array this scan was constructed on.
+     * @throws std::invalid_argument if inout is some other array
+     */
+    void prefixSumsInPlace(Data& inout) {
+        checkInPlace(inout);
+        downSweep(&inout, true);
+    }
+
+    /**
+     * @brief Compute the exclusive scan (output[k] combines elements [0, k)) into output.
+     * @param output Pointer to caller-owned output array with at least as many
+     *               elements as the input.
+     */
+    void exclusivePrefixSums(Data* output) {
+        downSweep(output, false);
+    }
+
+    /**
+     * @brief Overwrite the input with its exclusive scan; see prefixSumsInPlace.
+     * @param inout The array this scan was constructed on.
+     * @throws std::invalid_argument if inout is some other array
+     */
+    void exclusivePrefixSumsInPlace(Data& inout) {
+        checkInPlace(inout);
+        downSweep(&inout, false);
+    }
+
+private:
+    /** @brief Pointer to the caller-owned input data. */
+    const Data* data;
+    /** @brief Scheduler both passes fork onto. */
+    ForkJoinPool& pool;
+    /** @brief Number of input elements. */
+    int size;
+    /** @brief Elements per leaf block (the last block may be shorter). */
+    int blockSize;
+    /** @brief Number of leaf blocks. */
+    int blocks;
+    /** @brief Block-tree node totals in pre-order; size 2*blocks - 1. */
+    Data totals;
+    /** @brief The combining operator. */
+    Op op;
+
+    /**
+     * @brief Block length giving about LEAVES_PER_WORKER blocks per worker.
+     * @param size Number of input elements.
+     * @param workers Pool size.
+     * @return Block length, at least MIN_BLOCK.
+     */
+    static int chooseBlockSize(int size, int workers) {
+        const long long leaves = static_cast<long long>(workers) * LEAVES_PER_WORKER;
+        const long long perLeaf = (size + leaves - 1) / leaves;
+        return static_cast<int>(std::max<long long>(perLeaf, MIN_BLOCK));
+    }
+
+    void checkInPlace(const Data& inout) const {
+        if (&inout != data) {
+            throw std::invalid_argument("in-place scan must be given the array it was built on");
+        }
+    }
+
+    void downSweep(Data* output, bool inclusive) {
+        if (blocks > 0) {
+            pool.invoke([&] { calcPrefixSums(0, 0, blocks, Op::identity(), inclusive, output); });
+        }
+    }
+
+    int blockBegin(int b) const {
+        return b * blockSize;
+    }
+
+    int blockEnd(int b) const {
+        return std::min(size, (b + 1) * blockSize);
+    }
+
+    /**
+     * @brief Compute the totals for node i covering blocks [lo, hi).
+     *
+     * @param i Pre-order node index.
+     * @param lo First block.
+     * @param hi One past the last block.
+     */
+    void calcSum(int i, int lo, int hi) {
+        if (hi - lo == 1) {
+            totals[i] = reduce(data->data() + blockBegin(lo), blockEnd(lo) - blockBegin(lo));
+            return;
+        }
+
+        const int mid = lo + (hi - lo) / 2;
+        const int leftChild = i + 1;
+        const int rightChild = i + 2 * (mid - lo);
+        pool.forkJoin(
+            [&] { calcSum(leftChild, lo, mid); },
+            [&] { calcSum(rightChild, mid, hi); }
+            );
+        totals[i] = op(totals[leftChild], totals[rightChild]);
+    }
+
+    /**
+     * @brief Write the scan for blocks [lo, hi) under node i.
+     *
+     * @param i Pre-order node index.
+     * @param lo First block.
+     * @param hi One past the last block.
+     * @param prior Total of all elements before block lo.
+     * @param inclusive Whether each output includes its own element.
+     * @param output Output array to fill (may be the input array).
+     */
+    void calcPrefixSums(int i, int lo, int hi, T prior, bool inclusive, Data* output) {
+        if (hi - lo == 1) {
+            const int begin = blockBegin(lo);
+            const int count = blockEnd(lo) - begin;
+            if (inclusive) {
+                scan(data->data() + begin, output->data() + begin, count, prior);
+            } else {
+                exclusiveScan(data->data() + begin, output->data() + begin, count, prior);
+            }
+            return;
+        }
+
+        const int mid = lo + (hi - lo) / 2;
+        const int leftChild = i + 1;
+        const int rightChild = i + 2 * (mid - lo);
+        const T leftTotal = totals[leftChild];
+        pool.forkJoin(
+            [&] { calcPrefixSums(leftChild, lo, mid, prior, inclusive, output); },
+            [&] { calcPrefixSums(rightChild, mid, hi, op(prior, leftTotal), inclusive, output); }
+            );
+    }
+
+    /** @brief Sequential reduction of one block. */
+    T reduce(const T* in, int count) const {
+        if constexpr (std::is_same<T, int>::value && std::is_same<Op, Plus<int>>::value) {
+            return ScanKernels::reduce(in, count);
+        } else {
+            T total = Op::identity();
+            for (int j = 0; j < count; j++) {
+                total = op(total, in[j]);
+            }
+            return total;
+        }
+    }
+
+    /** @brief Sequential inclusive scan of one block seeded with prior. */
+    void scan(const T* in, T* out, int count, T prior) const {
+        if constexpr (std::is_same<T, int>::value && std::is_same<Op, Plus<int>>::value) {
+            ScanKernels::inclusiveScan(in, out, count, prior);
+        } else {
+            for (int j = 0; j < count; j++) {
+                prior = op(prior, in[j]);
+                out[j] = prior;
+            }
+        }
+    }
+
+    /** @brief Sequential exclusive scan of one block seeded with prior; in may equal out. */
+    void exclusiveScan(const T* in, T* out, int count, T prior) const {
+        for (int j = 0; j < count; j++) {
+            const T x = in[j];
+            out[j] = prior;
+            prior = op(prior, x);
+        }
+    }
+};
@@ -0,0 +1,105 @@
+/**
+ * @file ScanKernels.h
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Sequential reduce and inclusive-scan kernels over contiguous int ranges.
+ *
+ * These are the inner loops of BlockScan. Each has an AVX2 path (8 lanes), an SSE2
+ * path (4 lanes) and a scalar tail/fallback, chosen at compile time from the target
+ * flags (see -march in the Makefile).
+ *
+ * The in-register scan is the usual log-step shift-and-add: after adding the vector
+ * shifted by one lane and then by two lanes, lane j holds x[0] + ... + x[j]. The
+ * running carry from earlier vectors is broadcast and added to every lane.
+ */
+
+#pragma once
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace ScanKernels {
+
+/**
+ * @brief Sum of in[0, n).
+ * @param in Input values.
+ * @param n Number of values.
+ * @return in[0] + ... + in[n-1] (wrapping like int addition in the scalar loop).
+ */
+inline int reduce(const int* in, int n) {
+    int i = 0;
+    int sum = 0;
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_add_epi32(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum = _mm_cvtsi128_si32(half);
+#elif defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_add_epi32(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum = _mm_cvtsi128_si32(acc);
+#endif
+    for (; i < n; i++) {
+        sum += in[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief out[j] = carry + in[0] + ... + in[j] for j in [0, n).
+ *
+ * in and out may be the same array.
+ *
+ * @param in Input values.
+ * @param out Output values.
+ * @param n Number of values.
+ * @param carry Sum of everything before in[0].
+ * @return carry + in[0] + ... + in[n-1].
+ */
+inline int inclusiveScan(const int* in, int* out, int n, int carry) {
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i running = _mm256_set1_epi32(carry);
+    const __m256i lastLane = _mm256_set1_epi32(7);
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        // scan within each 128-bit half
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+        // add the low half's total into the high half
+        __m256i lowTotal = _mm256_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+        x = _mm256_add_epi32(x, _mm256_permute2x128_si256(lowTotal, lowTotal, 0x08));
+        x = _mm256_add_epi32(x, running);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+        running = _mm256_permutevar8x32_epi32(x, lastLane);
+    }
+    carry = _mm256_cvtsi256_si32(running);
+#elif defined(__SSE2__)
+    __m128i running = _mm_set1_epi32(carry);
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, running);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), x);
+        running = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    carry = _mm_cvtsi128_si32(running);
+#endif
+    for (; i < n; i++) {
+        carry += in[i];
+        out[i] = carry;
+    }
+    return carry;
+}
+
+}  // namespace ScanKernels
@@ -0,0 +1,267 @@
+/**
+ * @file SegmentedScan.h
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Many independent scans, one per segment, in one pass over the heap tree.
+ *
+ * Segments are marked either by a flag array (flags[k] != 0 means a segment starts
+ * at k) or by a list of segment start offsets. Each tree node carries a pair
+ * (head, total): whether a segment starts anywhere in its subtree, and the total of
+ * its elements from the last segment start onward. Combining a left pair with a
+ * right pair restarts at the right pair when it contains a head:
+ *
+ *     (hl, vl) . (hr, vr) = (hl || hr, hr ? vr : op(vl, vr))
+ *
+ * This operator is associative, so the usual up-sweep/down-sweep on a single
+ * Heaper tree scans every segment at once, however small and numerous the segments
+ * are, instead of building one tree per segment.
+ */
+
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "ForkJoinPool.h"
+#include "Scan.h"
+
+/** @brief Tree node value for a segmented scan. */
+template <typename T>
+struct Segment {
+    /** @brief A segment starts somewhere in this node's range. */
+    bool head;
+    /** @brief Total of this node's elements since the last segment start in its range. */
+    T value;
+};
+
+/** @brief Lifts an operator on T to the segmented operator on Segment<T>. */
+template <typename T, typename Op>
+struct Segmented {
+    static Segment<T> identity() { return Segment<T>{false, Op::identity()}; }
+
+    Segment<T> operator()(const Segment<T>& a, const Segment<T>& b) const {
+        return b.head ? b : Segment<T>{a.head, op(a.value, b.value)};
+    }
+
+    Op op;
+};
+
+/**
+ * @class SegmentedScan
+ * @brief Segmented inclusive/exclusive scan over the heap-shaped tree.
+ *
+ * Construction performs the up-sweep pass; the prefix methods perform the down-sweep.
+ * Element 0 always starts a segment.
+ *
+ * @tparam T Element type.
+ * @tparam Op Associative operator with static identity().
+ */
+template <typename T, typename Op>
+class SegmentedScan: public Heaper<Segment<T>> {
+public:
+    typedef std::vector<T> Data;
+    /** @brief One byte per element; nonzero marks the first element of a segment. */
+    typedef std::vector<uint8_t> Flags;
+
+    /**
+     * @brief Build the tree from a flag array (up-sweep).
+     * @param data Pointer to the input array (caller-owned).
+     * @param flags Pointer to segment-start flags, same length as data (caller-owned).
+     * @param pool Scheduler both passes fork onto; defaults to the shared pool.
+     * @throws std::invalid_argument if the lengths differ
+     */
+    SegmentedScan(const Data* data, const Flags* flags, ForkJoinPool& pool = ForkJoinPool::common())
+        : Heaper<Segment<T>>(static_cast<int>(data->size())), values(data), flags(flags),
+          pool(pool), forkDepth(pool.defaultForkDepth()) {
+        if (flags->size() != data->size()) {
+            throw std::invalid_argument("segment flags must be the same length as the data");
+        }
+        calcSum();
+    }
+
+    /**
+     * @brief Build the tree from segment start offsets (up-sweep).
+     * @param data Pointer to the input array (caller-owned).
+     * @param offsets Index of the first element of each segment, each in [0, data->size()).
+     * @param pool Scheduler both passes fork onto; defaults to the shared pool.
+     * @throws std::invalid_argument if an offset is out of range
+     */
+    SegmentedScan(const Data* data, const std::vector<int>& offsets,
+                  ForkJoinPool& pool = ForkJoinPool::common())
+        : Heaper<Segment<T>>(static_cast<int>(data->size())), values(data),
+          ownedFlags(data->size(), 0), flags(&ownedFlags),
+          pool(pool), forkDepth(pool.defaultForkDepth()) {
+        for (int offset: offsets) {
+            if (offset < 0 || offset >= originalSize) {
+                throw std::invalid_argument("segment offset out of range");
+            }
+            ownedFlags[offset] = 1;
+        }
+        calcSum();
+    }
+
+    /**
+     * @brief Write each segment's inclusive scan into output.
+     * @param output Pointer to caller-owned output array.
+     */
+    void prefixSums(Data* output) {
+        downSweep(output, true);
+    }
+
+    /**
+     * @brief Overwrite the input with each segment's inclusive scan, without a second
+     *        buffer. No further scans may be taken from this object afterwards.
+     * @param inout The array this scan was constructed on.
+     * @throws std::invalid_argument if inout is some other array
+     */
+    void prefixSumsInPlace(Data& inout) {
+        checkInPlace(inout);
+        downSweep(&inout, true);
+    }
+
+    /**
+     * @brief Write each segment's exclusive scan into output; the first element of
+     *        every segment gets Op::identity().
+     * @param output Pointer to caller-owned output array.
+     */
+    void exclusivePrefixSums(Data* output) {
+        downSweep(output, false);
+    }
+
+    /**
+     * @brief Overwrite the input with each segment's exclusive scan; see prefixSumsInPlace.
+     * @param inout The array this scan was constructed on.
+     * @throws std::invalid_argument if inout is some other array
+     */
+    void exclusivePrefixSumsInPlace(Data& inout) {
+        checkInPlace(inout);
+        downSweep(&inout, false);
+    }
+
+private:
+    using Heaper<Segment<T>>::originalSize;
+    using Heaper<Segment<T>>::n;
+    using Heaper<Segment<T>>::interior;
+    using Heaper<Segment<T>>::left;
+    using Heaper<Segment<T>>::right;
+    using Heaper<Segment<T>>::isLeaf;
+
+    /** @brief Pointer to the caller-owned input values (leaves). */
+    const Data* values;
+    /** @brief Flags built from offsets; empty when the caller supplied flags. */
+    Flags ownedFlags;
+    /** @brief Segment-start flags, either the caller's or @ref ownedFlags. */
+    const Flags* flags;
+    /** @brief Scheduler both passes fork onto. */
+    ForkJoinPool& pool;
+    /** @brief Tree levels [0, forkDepth) fork; deeper levels run in the calling worker. */
+    int forkDepth;
+    /** @brief The segmented combining operator. */
+    Segmented<T, Op> op;
+
+    void checkInPlace(const Data& inout) const {
+        if (&inout != values) {
+            throw std::invalid_argument("in-place scan must be given the array it was built on");
+        }
+    }
+
+    /**
+     * @brief Read the (head, total) pair of a tree node.
+     *
+     * Leaves beyond the input are the identity, which never restarts a segment.
+     *
+     * @param i Node index in the heap layout.
+     * @return Node value.
+     */
+    Segment<T> value(int i) const {
+        if (i < n - 1) {
+            return interior[i];
+        }
+
+        const int k = i - (n - 1);
+        if (k < originalSize) {
+            return Segment<T>{k == 0 || (*flags)[k] != 0, (*values)[k]};
+        }
+        return Segmented<T, Op>::identity();
+    }
+
+    void calcSum() {
+        pool.invoke([&] { calcSumHelper(0, 0); });
+    }
+
+    void downSweep(Data* output, bool inclusive) {
+        pool.invoke([&] {
+            calcPrefixSums(0, Segmented<T, Op>::identity(), 0, inclusive, output);
+        });
+    }
+
+    /**
+     * @brief Recursively compute (head, total) pairs for interior nodes.
+     *
+     * @param i Node index.
+     * @param currLevel Node i's current level -- always starts at 0 for root node.
+     */
+    void calcSumHelper(int i, int currLevel) {
+        if (isLeaf(i)) {
+            return;
+        }
+
+        const int leftChild = left(i);
+        const int rightChild = right(i);
+
+        if (currLevel < forkDepth) {
+            pool.forkJoin(
+                [&] { calcSumHelper(leftChild, currLevel + 1); },
+                [&] { calcSumHelper(rightChild, currLevel + 1); }
+                );
+        } else {
+            calcSumHelper(leftChild, currLevel + 1);
+            calcSumHelper(rightChild, currLevel + 1);
+        }
+
+        interior[i] = op(value(leftChild), value(rightChild));
+    }
+
+    /**
+     * @brief Recursively propagate segment offsets and write scan results.
+     *
+     * prior is the pair for everything before the subtree rooted at i, so prior.value
+     * is the running total of the segment that is open when the subtree begins. As in
+     * Scan, the left total is read before visiting either child so that output may be
+     * the input array.
+     *
+     * @param i Node index.
+     * @param prior Pair for all elements before this subtree.
+     * @param currLevel Node i's current level -- always starts at 0 for root node.
+     * @param inclusive Whether each output includes its own element.
+     * @param output Output array to fill.
+     */
+    void calcPrefixSums(int i, Segment<T> prior, int currLevel, bool inclusive, Data* output) {
+        if (isLeaf(i)) {
+            const int k = i - (n - 1);
+            if (k < originalSize) {
+                const Segment<T> leaf = value(i);
+                if (inclusive) {
+                    (*output)[k] = op(prior, leaf).value;
+                } else {
+                    (*output)[k] = leaf.head ? Op::identity() : prior.value;
+                }
+            }
+            return;
+        }
+
+        const int leftChild = left(i);
+        const int rightChild = right(i);
+        const Segment<T> rightPrior = op(prior, value(leftChild));
+
+        if (currLevel < forkDepth) {
+            pool.forkJoin(
+                [&] { calcPrefixSums(leftChild, prior, currLevel + 1, inclusive, output); },
+                [&] { calcPrefixSums(rightChild, rightPrior, currLevel + 1, inclusive, output); }
+                );
+        } else {
+            calcPrefixSums(leftChild, prior, currLevel + 1, inclusive, output);
+            calcPrefixSums(rightChild, rightPrior, currLevel + 1, inclusive, output);
+        }
+    }
+};
@@ -0,0 +1,155 @@
+/**
+ * @file StreamScan.h
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Prefix sums of binary files too large to hold in memory.
+ *
+ * The input is read in fixed-size chunks. Each chunk is scanned in place in parallel
+ * with ImplicitScan (see Scan.h), seeded with the running total of all earlier chunks
+ * by adding that total into the chunk's first element, and is then written out.
+ *
+ * Reads are double-buffered: while one chunk is scanned and written, the next chunk
+ * is read into the other buffer by a background task. Peak memory is two chunks
+ * (plus ImplicitScan's few KB of block totals), whatever the size of the input.
+ */
+
+#pragma once
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "ForkJoinPool.h"
+#include "Scan.h"
+
+/**
+ * @class StreamScan
+ * @brief Chunked, double-buffered inclusive prefix sum from one stream to another.
+ *
+ * @tparam In  Element type stored in the input (native byte order).
+ * @tparam Out Element type written to the output; at least as wide as In, so that
+ *             e.g. int32 inputs can be summed into int64 without overflow.
+ */
+template <typename In, typename Out = In>
+class StreamScan {
+    static_assert(sizeof(Out) >= sizeof(In), "output elements must be at least as wide as input");
+
+public:
+    /** @brief Default elements per chunk (2^24, i.e. 128 MiB of 8-byte outputs). */
+    static constexpr int DEFAULT_CHUNK = 1 << 24;
+
+    /**
+     * @param chunkElements Elements per chunk; memory use is about 2 * chunkElements * sizeof(Out).
+     * @param pool Scheduler each chunk's scan runs on; defaults to the shared pool.
+     */
+    explicit StreamScan(int chunkElements = DEFAULT_CHUNK, ForkJoinPool& pool = ForkJoinPool::common())
+        : chunkElements(chunkElements), pool(pool) {
+        if (chunkElements <= 0) {
+            throw std::invalid_argument("chunk size must be positive");
+        }
+    }
+
+    /**
+     * @brief Scan every element of in and write the prefix sums to out.
+     * @param in Binary input stream of In values.
+     * @param out Binary output stream for Out values.
+     * @return Total of all input elements.
+     * @throws std::runtime_error if the input ends mid-element or a write fails
+     */
+    Out run(std::istream& in, std::ostream& out) {
+        std::vector<Out> buffers[2] = {std::vector<Out>(chunkElements), std::vector<Out>(chunkElements)};
+        Out carry = Out();
+
+        int current = 0;
+        std::future<int> pending = std::async(std::launch::async, &StreamScan::readChunk,
+                                              this, std::ref(in), &buffers[current]);
+        while (true) {
+            const int count = pending.get();
+            if (count == 0) {
+                break;
+            }
+
+            // start reading the next chunk into the other buffer while this one is scanned
+            const int next = 1 - current;
+            pending = std::async(std::launch::async, &StreamScan::readChunk,
+                                 this, std::ref(in), &buffers[next]);
+
+            std::vector<Out>& chunk = buffers[current];
+            chunk.resize(count);
+            chunk[0] += carry;
+            ImplicitScan<Out, Plus<Out>> scan(&chunk, pool);
+            scan.prefixSumsInPlace(chunk);
+            carry = chunk[count - 1];
+
+            out.write(reinterpret_cast<const char*>(chunk.data()), count * sizeof(Out));
+            if (!out) {
+                throw std::runtime_error("Could not write output.");
+            }
+            chunk.resize(chunkElements);
+            current = next;
+        }
+        return carry;
+    }
+
+    /**
+     * @brief Scan the file at inPath into a new file at outPath.
+     * @param inPath Binary input file of In values.
+     * @param outPath Output file for Out values (created or truncated).
+     * @return Total of all input elements.
+     * @throws std::runtime_error if either file cannot be opened, or as for run(istream, ostream)
+     */
+    Out run(const std::string& inPath, const std::string& outPath) {
+        std::ifstream in(inPath, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("Could not open input file.");
+        }
+        std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Could not open output file.");
+        }
+        return run(in, out);
+    }
+
+private:
+    /** @brief Elements per chunk. */
+    int chunkElements;
+    /** @brief Scheduler each chunk's scan runs on. */
+    ForkJoinPool& pool;
+
+    /**
+     * @brief Read up to chunkElements In values into buffer, widened to Out.
+     *
+     * The raw In values are read into the front of buffer's own storage and widened
+     * from the back forward: element j's Out slot starts at or after raw element j,
+     * which has just been read, and ends before no raw element below j, so no unread
+     * input is overwritten and no staging buffer is needed.
+     *
+     * @param in Input stream.
+     * @param buffer Destination; must hold chunkElements values.
+     * @return Number of elements read (0 at end of input).
+     * @throws std::runtime_error if the input ends mid-element
+     */
+    int readChunk(std::istream& in, std::vector<Out>* buffer) {
+        char* bytes = reinterpret_cast<char*>(buffer->data());
+        in.read(bytes, static_cast<std::streamsize>(chunkElements) * sizeof(In));
+        const std::streamsize got = in.gcount();
+        if (got % sizeof(In) != 0) {
+            throw std::runtime_error("Malformed input file.");
+        }
+        const int count = static_cast<int>(got / sizeof(In));
+
+        if constexpr (!std::is_same<In, Out>::value) {
+            for (int j = count - 1; j >= 0; j--) {
+                In raw;
+                std::memcpy(&raw, bytes + j * sizeof(In), sizeof(In));
+                (*buffer)[j] = static_cast<Out>(raw);
+            }
+        }
+        return count;
+    }
+};
@@ -0,0 +1,76 @@
+/**
+ * @file mpi_scan.cpp
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Driver for MPIScan: the hw1 test array (10 followed by 1s) scanned across
+ *        all MPI ranks.
+ *
+ * Each rank builds only its own piece of the N-element array (pieces differ in size
+ * by at most one element), scans it with MPIScan and checks it. No rank ever holds
+ * the whole array. ROOT reports the slowest rank's time.
+ *
+ * Usage:
+ *   mpirun -n <p> ./mpi_scan
+ */
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <mpi.h>
+#include "MPIScan.h"
+using namespace std;
+const int N = 100000000;
+const int ROOT = 0;
+
+typedef vector<int> Data;
+
+int main() {
+    // ForkJoinPool workers never call MPI, so only the main thread needs it
+    int provided;
+    MPI_Init_thread(nullptr, nullptr, MPI_THREAD_FUNNELED, &provided);
+    int rank, p;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+
+    // spread the remainder one element each over the first N % p ranks
+    const int base = N / p;
+    const int extra = N % p;
+    const int m = base + (rank < extra ? 1 : 0);
+    const int first = rank * base + min(rank, extra);
+
+    Data data(m, 1);
+    if (first == 0 && m > 0) {
+        data[0] = 10;
+    }
+    Data prefix(m);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = chrono::steady_clock::now();
+
+    MPIScan<int> scan(&data);
+    scan.prefixSums(&prefix);
+
+    auto end = chrono::steady_clock::now();
+    double elapsed = chrono::duration<double,milli>(end-start).count();
+
+    int failed = 0;
+    int check = 10 + first;
+    for (int elem: prefix)
+        if (elem != check++) {
+            cout << rank << " FAILED RESULT at " << check-1-10 << endl;
+            failed = 1;
+            break;
+        }
+
+    double slowest;
+    int anyFailed;
+    MPI_Reduce(&elapsed, &slowest, 1, MPI_DOUBLE, MPI_MAX, ROOT, MPI_COMM_WORLD);
+    MPI_Reduce(&failed, &anyFailed, 1, MPI_INT, MPI_MAX, ROOT, MPI_COMM_WORLD);
+    if (rank == ROOT) {
+        cout << p << " ranks" << (anyFailed ? " FAILED" : "") << " in " << slowest << "ms" << endl;
+    }
+
+    MPI_Finalize();
+    return 0;
+}
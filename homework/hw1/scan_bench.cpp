@@ -0,0 +1,206 @@
+/**
+ * @file scan_bench.cpp
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Throughput sweep of every int prefix-sum engine, written as CSV.
+ *
+ * For each size n (every power of two from 2^minLog2 to 2^maxLog2, plus the
+ * non-power-of-two 3 * 2^(k-1) - 1 between each pair), each thread count and,
+ * for the Scan heap tree, each fork depth, the engine is constructed and run
+ * reps times on the hw1 test array (10 followed by 1s). Each rep covers the same
+ * work hw1.cpp times: construction (up-sweep) plus prefixSums (down-sweep).
+ * Every run's output is checked outside the timing.
+ *
+ * std::inclusive_scan, sequential and with std::execution::par, runs on the same
+ * input for comparison. The parallel policy uses its own runtime's threads, so it
+ * is reported once per size with threads set to the machine's thread count.
+ *
+ * One CSV row per (engine, n, threads, forkDepth) goes to stdout:
+ *   engine,n,threads,fork_depth,reps,median_ms,p99_ms,gb_per_s
+ * fork_depth is empty for engines that do not take one; gb_per_s counts one
+ * int read and one int written per element at the median time.
+ *
+ * Usage:
+ *   ./scan_bench [--min-log2 k] [--max-log2 k] [--threads 1,2,4] [--depths 0,4,8,16]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <execution>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BlockScan.h"
+#include "ForkJoinPool.h"
+#include "Scan.h"
+using namespace std;
+
+typedef vector<int> Data;
+
+/** @brief Sizes are timed until at least this many elements have been scanned. */
+const long long ELEMENTS_PER_POINT = 1LL << 26;
+const int MIN_REPS = 5;
+const int MAX_REPS = 200;
+
+/**
+ * @brief Parse a comma-separated list of ints.
+ * @param list Text such as "1,2,4".
+ * @return The values, in order.
+ */
+vector<int> parseList(const string& list) {
+    vector<int> values;
+    stringstream in(list);
+    string item;
+    while (getline(in, item, ',')) {
+        values.push_back(stoi(item));
+    }
+    return values;
+}
+
+/**
+ * @brief Check that prefix counts up from 10, as for the hw1 test array.
+ * @param prefix Scan output.
+ * @return true if correct.
+ */
+bool check(const Data& prefix) {
+    int expect = 10;
+    for (int elem: prefix)
+        if (elem != expect++)
+            return false;
+    return true;
+}
+
+/**
+ * @brief Time reps runs of one engine and write its CSV row.
+ *
+ * @param engine Label for the row.
+ * @param n Number of elements.
+ * @param threads Thread count to report.
+ * @param forkDepth Fork depth to report, or -1 for none.
+ * @param reps Number of timed runs.
+ * @param run Runs the engine once, writing the prefix sums of data into prefix.
+ * @param data Input array.
+ * @param prefix Output array, same size as data.
+ * @return false if any run produced a wrong result.
+ */
+bool timeEngine(const char* engine, int n, int threads, int forkDepth, int reps,
+                const function<void(const Data&, Data&)>& run,
+                const Data& data, Data& prefix) {
+    vector<double> times(reps);
+    bool ok = true;
+    for (int r = 0; r < reps; r++) {
+        fill(prefix.begin(), prefix.end(), 0);
+
+        auto start = chrono::steady_clock::now();
+        run(data, prefix);
+        auto end = chrono::steady_clock::now();
+        times[r] = chrono::duration<double,milli>(end-start).count();
+
+        ok = ok && check(prefix);
+    }
+    if (!ok) {
+        cerr << engine << " FAILED RESULT at n=" << n << " threads=" << threads << endl;
+    }
+
+    sort(times.begin(), times.end());
+    const double median = times[reps / 2];
+    // nearest-rank 99th percentile
+    const double p99 = times[(99 * reps + 99) / 100 - 1];
+    const double gbPerSec = 2.0 * n * sizeof(int) / (median * 1e6);
+
+    cout << engine << ',' << n << ',' << threads << ',';
+    if (forkDepth >= 0) {
+        cout << forkDepth;
+    }
+    cout << ',' << reps << ',' << median << ',' << p99 << ',' << gbPerSec << endl;
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int minLog2 = 10;
+    int maxLog2 = 27;
+    const int machine = max(1, static_cast<int>(thread::hardware_concurrency()));
+    vector<int> threadCounts;
+    for (int w = 1; w < machine; w *= 2) {
+        threadCounts.push_back(w);
+    }
+    threadCounts.push_back(machine);
+    vector<int> depths = {0, 4, 8, 12, 16};
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const string flag = argv[i];
+        if (flag == "--min-log2") {
+            minLog2 = stoi(argv[i + 1]);
+        } else if (flag == "--max-log2") {
+            maxLog2 = stoi(argv[i + 1]);
+        } else if (flag == "--threads") {
+            threadCounts = parseList(argv[i + 1]);
+        } else if (flag == "--depths") {
+            depths = parseList(argv[i + 1]);
+        } else {
+            cerr << "Usage: ./scan_bench [--min-log2 k] [--max-log2 k] "
+                 << "[--threads 1,2,4] [--depths 0,4,8,16]" << endl;
+            return 1;
+        }
+    }
+    if (minLog2 < 1 || maxLog2 > 30 || minLog2 > maxLog2) {
+        cerr << "log2 sizes must satisfy 1 <= min <= max <= 30" << endl;
+        return 1;
+    }
+
+    vector<int> sizes;
+    for (int k = minLog2; k <= maxLog2; k++) {
+        sizes.push_back(1 << k);
+        if (k < maxLog2) {
+            sizes.push_back(3 * (1 << (k - 1)) - 1);
+        }
+    }
+
+    // one pool per thread count, reused across every size
+    vector<unique_ptr<ForkJoinPool>> pools;
+    for (int w: threadCounts) {
+        pools.emplace_back(new ForkJoinPool(w));
+    }
+
+    bool ok = true;
+    cout << "engine,n,threads,fork_depth,reps,median_ms,p99_ms,gb_per_s" << endl;
+    for (int n: sizes) {
+        Data data(n, 1);
+        data[0] = 10;
+        Data prefix(n);
+        const int reps = static_cast<int>(max<long long>(MIN_REPS, min<long long>(MAX_REPS, ELEMENTS_PER_POINT / n)));
+
+        ok &= timeEngine("std_seq", n, 1, -1, reps, [](const Data& in, Data& out) {
+            inclusive_scan(in.begin(), in.end(), out.begin());
+        }, data, prefix);
+        ok &= timeEngine("std_par", n, machine, -1, reps, [](const Data& in, Data& out) {
+            inclusive_scan(execution::par, in.begin(), in.end(), out.begin());
+        }, data, prefix);
+
+        for (unique_ptr<ForkJoinPool>& pool: pools) {
+            ForkJoinPool& p = *pool;
+            for (int depth: depths) {
+                ok &= timeEngine("scan", n, p.size(), depth, reps, [&p, depth](const Data& in, Data& out) {
+                    Scan<int, Plus<int>> heap(&in, p, depth);
+                    heap.prefixSums(&out);
+                }, data, prefix);
+            }
+            ok &= timeEngine("block_scan", n, p.size(), -1, reps, [&p](const Data& in, Data& out) {
+                BlockScan heap(&in, p);
+                heap.prefixSums(&out);
+            }, data, prefix);
+            ok &= timeEngine("implicit_scan", n, p.size(), -1, reps, [&p](const Data& in, Data& out) {
+                ImplicitScan<int, Plus<int>> heap(&in, p);
+                heap.prefixSums(&out);
+            }, data, prefix);
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file scan_types.cpp
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Times and checks each Scan<T, Op> instantiation we use.
+ *
+ * Every instantiation is run on the same (non-power-of-two) size so the numbers are
+ * comparable, and is checked outside the timing against a plain sequential scan
+ * with the same operator.
+ *
+ * The remaining modes of Scan and ImplicitScan (in place, exclusive, exclusive in
+ * place) are then checked, untimed, with non-Plus operators on odd sizes, including
+ * sizes small enough that index 0 and the padded leaves are the interesting cases.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Scan.h"
+using namespace std;
+const int N = (1 << 24) + 3;
+
+/** @brief Exact comparison for integral types. */
+template <typename T>
+bool close(const T& got, const T& want) {
+    return got == want;
+}
+
+/** @brief Relative comparison: the tree and the sequential loop round differently. */
+bool close(double got, double want) {
+    return fabs(got - want) <= 1e-6 * max(1.0, fabs(want));
+}
+
+bool close(float got, float want) {
+    return fabs(got - want) <= 1e-4f * max(1.0f, fabs(want));
+}
+
+template <typename T>
+bool close(const AffineMap<T>& got, const AffineMap<T>& want) {
+    return close(got.a, want.a) && close(got.b, want.b);
+}
+
+/**
+ * @brief Time Scan<T, Op> on data, then check it against a sequential scan.
+ *
+ * @param name Label for the report.
+ * @param data Input values.
+ */
+template <typename T, typename Op>
+void timeScan(const char* name, const vector<T>& data) {
+    vector<T> prefix(data.size());
+
+    // start timer
+    auto start = chrono::steady_clock::now();
+
+    Scan<T, Op> scan(&data);
+    scan.prefixSums(&prefix);
+
+    // stop timer
+    auto end = chrono::steady_clock::now();
+    auto elapsed = chrono::duration<double,milli>(end-start).count();
+
+    Op op;
+    T running = Op::identity();
+    for (size_t i = 0; i < data.size(); i++) {
+        running = op(running, data[i]);
+        if (!close(prefix[i], running)) {
+            cout << name << " FAILED RESULT at " << i << endl;
+            return;
+        }
+    }
+    cout << name << " in " << elapsed << "ms" << endl;
+}
+
+/**
+ * @brief Compare one scan mode's output with the sequential reference.
+ *
+ * @param name Label for the report.
+ * @param mode Which mode produced got.
+ * @param got Engine output.
+ * @param want Sequential reference.
+ * @return true if every element matches
+ */
+template <typename T>
+bool matches(const string& name, const char* mode, const vector<T>& got, const vector<T>& want) {
+    for (size_t i = 0; i < want.size(); i++) {
+        if (!close(got[i], want[i])) {
+            cout << name << " " << mode << " FAILED RESULT at " << i << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Check Engine's in-place, exclusive and exclusive in-place scans against
+ * sequential scans; output[i] of an exclusive scan combines data[0, i), so
+ * output[0] is Op::identity().
+ *
+ * @tparam Engine Scan<T, Op> or ImplicitScan<T, Op>.
+ * @param name Label for the report.
+ * @param data Input values.
+ */
+template <typename Engine, typename T, typename Op>
+void checkModes(const char* name, const vector<T>& data) {
+    const string label = string(name) + " n=" + to_string(data.size());
+
+    Op op;
+    vector<T> inclusive(data.size()), exclusive(data.size());
+    T running = Op::identity();
+    for (size_t i = 0; i < data.size(); i++) {
+        exclusive[i] = running;
+        running = op(running, data[i]);
+        inclusive[i] = running;
+    }
+
+    bool ok = true;
+    vector<T> output(data.size());
+    Engine scan(&data);
+    scan.exclusivePrefixSums(&output);
+    ok = matches(label, "exclusive", output, exclusive) && ok;
+
+    vector<T> inout = data;
+    Engine inPlace(&inout);
+    inPlace.prefixSumsInPlace(inout);
+    ok = matches(label, "in place", inout, inclusive) && ok;
+
+    inout = data;
+    Engine exclusiveInPlace(&inout);
+    exclusiveInPlace.exclusivePrefixSumsInPlace(inout);
+    ok = matches(label, "exclusive in place", inout, exclusive) && ok;
+
+    if (ok) {
+        cout << label << " in place/exclusive OK" << endl;
+    }
+}
+
+int main() {
+    mt19937 random(5600);
+    uniform_int_distribution<int> small(-100, 100);
+
+    vector<int> ints(N);
+    vector<int64_t> longs(N);
+    vector<float> floats(N);
+    vector<double> doubles(N);
+    vector<AffineMap<double>> maps(N);
+    for (int i = 0; i < N; i++) {
+        ints[i] = small(random);
+        longs[i] = int64_t(ints[i]) << 32;
+        floats[i] = static_cast<float>(ints[i] % 4);
+        doubles[i] = ints[i] / 8.0;
+        // stay close to 1 so the composed map neither vanishes nor blows up
+        maps[i] = AffineMap<double>{1.0 + ints[i] * 1e-9, ints[i] / 100.0};
+    }
+
+    timeScan<int, Plus<int>>("Scan<int, Plus>", ints);
+    timeScan<int64_t, Plus<int64_t>>("Scan<int64_t, Plus>", longs);
+    timeScan<float, Plus<float>>("Scan<float, Plus>", floats);
+    timeScan<double, Plus<double>>("Scan<double, Plus>", doubles);
+    timeScan<int, Max<int>>("Scan<int, Max>", ints);
+    timeScan<int, Min<int>>("Scan<int, Min>", ints);
+    timeScan<double, Max<double>>("Scan<double, Max>", doubles);
+    timeScan<AffineMap<double>, Compose<double>>("Scan<AffineMap<double>, Compose>", maps);
+
+    // odd sizes: a single element, a padded tree of three, a few blocks plus one, and N
+    for (int size: {1, 3, 3 * ImplicitScan<int, Max<int>>::MIN_BLOCK + 1, N}) {
+        const vector<int> someInts(ints.begin(), ints.begin() + size);
+        const vector<AffineMap<double>> someMaps(maps.begin(), maps.begin() + size);
+        checkModes<Scan<int, Max<int>>, int, Max<int>>("Scan<int, Max>", someInts);
+        checkModes<ImplicitScan<int, Max<int>>, int, Max<int>>("ImplicitScan<int, Max>", someInts);
+        checkModes<Scan<AffineMap<double>, Compose<double>>, AffineMap<double>, Compose<double>>(
+            "Scan<AffineMap<double>, Compose>", someMaps);
+        checkModes<ImplicitScan<AffineMap<double>, Compose<double>>, AffineMap<double>, Compose<double>>(
+            "ImplicitScan<AffineMap<double>, Compose>", someMaps);
+    }
+    return 0;
+}
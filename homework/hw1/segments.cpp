@@ -0,0 +1,79 @@
+/**
+ * @file segments.cpp
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Times many small prefix sums done as one SegmentedScan pass versus one
+ *        Scan (SumHeap-style tree) per segment.
+ *
+ * Each segment holds a 10 followed by 1s, so every segment's inclusive scan is
+ * 10, 11, 12, ...; the check runs outside the timing.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "Scan.h"
+#include "SegmentedScan.h"
+using namespace std;
+const int N = 1 << 22;
+
+typedef vector<int> Data;
+
+/**
+ * @brief Check that every segment of prefix counts up from 10.
+ * @param prefix Scan results.
+ * @param offsets Segment start offsets.
+ * @return true if correct.
+ */
+bool check(const Data& prefix, const vector<int>& offsets) {
+    for (size_t s = 0; s < offsets.size(); s++) {
+        const int end = s + 1 < offsets.size() ? offsets[s + 1] : static_cast<int>(prefix.size());
+        int expect = 10;
+        for (int i = offsets[s]; i < end; i++) {
+            if (prefix[i] != expect++) {
+                cout << "FAILED RESULT at " << i << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main() {
+    for (int segmentLength: {4, 64, 4096}) {
+        Data data(N, 1);
+        vector<int> offsets;
+        for (int i = 0; i < N; i += segmentLength) {
+            offsets.push_back(i);
+            data[i] = 10;
+        }
+        Data prefix(N);
+
+        auto start = chrono::steady_clock::now();
+        SegmentedScan<int, Plus<int>> segmented(&data, offsets);
+        segmented.prefixSums(&prefix);
+        auto end = chrono::steady_clock::now();
+        const double onePass = chrono::duration<double,milli>(end-start).count();
+        check(prefix, offsets);
+
+        start = chrono::steady_clock::now();
+        for (size_t s = 0; s < offsets.size(); s++) {
+            const int from = offsets[s];
+            const int to = s + 1 < offsets.size() ? offsets[s + 1] : N;
+            Data piece(data.begin() + from, data.begin() + to);
+            Data piecePrefix(piece.size());
+            Scan<int, Plus<int>> heap(&piece);
+            heap.prefixSums(&piecePrefix);
+            copy(piecePrefix.begin(), piecePrefix.end(), prefix.begin() + from);
+        }
+        end = chrono::steady_clock::now();
+        const double perSegment = chrono::duration<double,milli>(end-start).count();
+        check(prefix, offsets);
+
+        cout << offsets.size() << " segments of " << segmentLength << ": "
+             << "one segmented pass " << onePass << "ms, "
+             << "one tree per segment " << perSegment << "ms" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file stream_scan.cpp
+ * @author Junwen Zheng
+ * @date Jan 17, 2026
+ *
+ * @brief Driver for StreamScan: prefix sums of a binary file of int32 values into a
+ *        binary file of int64 sums.
+ *
+ * Usage:
+ *   ./stream_scan <input> <output> [chunkElements]   scan input into output
+ *   ./stream_scan --generate <file> <count>          write 10, 1, 1, ... (count ints)
+ *   ./stream_scan --check <file>                     check output of a generated input
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "StreamScan.h"
+using namespace std;
+
+/**
+ * @brief Write the same test pattern hw1.cpp uses: a 10 followed by 1s.
+ * @param path Output file.
+ * @param count Number of int32 values.
+ */
+void generate(const string& path, long long count) {
+    ofstream out(path, ios::binary | ios::trunc);
+    vector<int32_t> block(1 << 20, 1);
+    block[0] = 10;
+    for (long long written = 0; written < count; written += block.size()) {
+        const long long n = min<long long>(block.size(), count - written);
+        out.write(reinterpret_cast<const char*>(block.data()), n * sizeof(int32_t));
+        block[0] = 1;
+    }
+}
+
+/**
+ * @brief Check that the scan of a generated input counts up from 10.
+ * @param path Scan output file of int64 sums.
+ * @return true if correct.
+ */
+bool check(const string& path) {
+    ifstream in(path, ios::binary);
+    vector<int64_t> block(1 << 20);
+    int64_t expect = 10;
+    while (in) {
+        in.read(reinterpret_cast<char*>(block.data()), block.size() * sizeof(int64_t));
+        const long long n = in.gcount() / sizeof(int64_t);
+        for (long long i = 0; i < n; i++) {
+            if (block[i] != expect++) {
+                cout << "FAILED RESULT at " << expect - 11 << endl;
+                return false;
+            }
+        }
+    }
+    cout << "checked " << expect - 10 << " sums" << endl;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 4 && string(argv[1]) == "--generate") {
+        generate(argv[2], stoll(argv[3]));
+        return 0;
+    }
+    if (argc == 3 && string(argv[1]) == "--check") {
+        return check(argv[2]) ? 0 : 1;
+    }
+    if (argc < 3) {
+        cerr << "Usage: ./stream_scan <input> <output> [chunkElements]\n"
+             << "       ./stream_scan --generate <file> <count>\n"
+             << "       ./stream_scan --check <file>\n";
+        return 1;
+    }
+
+    const int chunk = argc > 3 ? stoi(argv[3]) : StreamScan<int32_t, int64_t>::DEFAULT_CHUNK;
+    StreamScan<int32_t, int64_t> scan(chunk);
+
+    auto start = chrono::steady_clock::now();
+    const int64_t total = scan.run(argv[1], argv[2]);
+    auto end = chrono::steady_clock::now();
+    auto elapsed = chrono::duration<double,milli>(end-start).count();
+
+    cout << "total " << total << " in " << elapsed << "ms" << endl;
+    return 0;
+}
@@ -0,0 +1,320 @@
+/**
+* @file BlockedDistances.h - cache-tiled nearest-centroid search for many elements at once
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#pragma once  // only process the first time it is included; ignore otherwise
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <sys/types.h>
+#include <vector>
+#include "DistanceKernels.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// VNNI's vpdpbusd multiplies unsigned by signed bytes and sums groups of four straight
+// into 32-bit lanes: one instruction per 32 bytes per pair, with no widening
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+#define BLOCKED_DISTANCES_VNNI 1
+#define BLOCKED_DISTANCES_DPBUSD _mm256_dpbusd_epi32
+#elif defined(__AVXVNNI__)
+#define BLOCKED_DISTANCES_VNNI 1
+#define BLOCKED_DISTANCES_DPBUSD _mm256_dpbusd_avx_epi32
+#endif
+
+/**
+ * Squared Euclidean distances from a block of elements to all k centroids, computed as
+ *
+ *     ||x - c||^2 = ||x||^2 + ||c||^2 - 2 x.c
+ *
+ * so that the work is a (rows x d) by (d x k) integer matrix product plus two norm vectors.
+ * Element norms are computed once per partition (setRows) and centroid norms once per
+ * generation (setCentroids).
+ *
+ * The product is tiled like a GEMM: rows are taken ROW_TILE at a time and centroids
+ * CENTROID_TILE at a time so both tiles stay in cache, and inside a tile a register-blocked
+ * micro-kernel produces a 2-row by 4-centroid block of dot products per pass over d,
+ * loading each row and centroid byte once per block rather than once per pair. All the
+ * arithmetic is exact in integers, so the closest centroid is exactly the one
+ * DistanceKernels::closest would pick (lowest index on ties).
+ *
+ * On CPUs with VNNI the micro-kernel uses vpdpbusd, which needs one signed operand, so
+ * the centroids are stored biased by -128 and x.c is recovered as x.(c - 128) + 128 sum(x),
+ * with sum(x) computed alongside ||x||^2. This is the main gain over the per-pair kernel,
+ * whose byte differences have to be widened to 16 bits before they can be squared.
+ * Without VNNI an AVX2 micro-kernel (16 bytes per step, widened) is used, and without
+ * AVX2 assign() falls back to the per-pair kernel.
+ *
+ * Template parameters:
+ *  - k: number of centroids
+ *  - d: dimensionality (bytes per element)
+ */
+template <int k, int d>
+class BlockedDistances {
+public:
+    typedef std::array<u_char,d> Element;
+
+    /** Rows per cache tile (ROW_TILE * d bytes of elements). */
+    static constexpr int ROW_TILE = 128;
+    /** Centroids per cache tile (CENTROID_TILE * d bytes of centroids). */
+    static constexpr int CENTROID_TILE = 32;
+
+    /**
+     * Record the elements to be assigned and compute their squared norms.
+     * @param data m elements (caller-owned; must stay valid while assign() is used)
+     * @param data_m number of elements
+     */
+    void setRows(const Element *data, int data_m) {
+        rows = data;
+        m = data_m;
+        rowNorms.resize(m);
+        rowSums.resize(m);
+        const Element zero{};
+        for (int i = 0; i < m; i++) {
+            rowNorms[i] = DistanceKernels::squaredL2<d>(rows[i], zero);
+            std::int64_t sum = 0;
+            for (int dim = 0; dim < d; dim++) {
+                sum += rows[i][dim];
+            }
+            rowSums[i] = sum;
+        }
+    }
+
+    /**
+     * Copy the current centroids into a contiguous buffer and compute their squared norms.
+     * The buffer is padded to a multiple of 4 centroids whose norms are too large ever to
+     * be the closest.
+     * @param clusters k clusters, each with a centroid member
+     */
+    template <typename Clusters>
+    void setCentroids(const Clusters& clusters) {
+        const Element zero{};
+        for (int j = 0; j < k; j++) {
+            centroids[j] = clusters[j].centroid;
+            centroidNorms[j] = DistanceKernels::squaredL2<d>(centroids[j], zero);
+        }
+        for (int j = k; j < PADDED_K; j++) {
+            centroids[j] = zero;
+            centroidNorms[j] = UNREACHABLE;
+        }
+        for (int j = 0; j < PADDED_K; j++) {
+            for (int dim = 0; dim < d; dim++) {
+                biased[j][dim] = static_cast<std::int8_t>(centroids[j][dim] - 128);
+            }
+        }
+    }
+
+    /**
+     * Assign rows [lo, hi) to their closest centroids.
+     * @param lo first row
+     * @param hi one past the last row
+     * @param labels labels[i] is set to the index of the centroid closest to row i
+     * @param nearest nearest[i] is set to the Euclidean distance from row i to that centroid
+     */
+    void assign(int lo, int hi, std::uint32_t *labels, double *nearest) const {
+#if !defined(__AVX2__)
+        // without wide integer multiplies the per-pair kernel (SSE2 or scalar) is faster
+        for (int i = lo; i < hi; i++) {
+            int min = 0;
+            std::uint32_t best = DistanceKernels::squaredL2<d>(centroids[0], rows[i]);
+            for (int j = 1; j < k; j++) {
+                const std::uint32_t dj = DistanceKernels::squaredL2<d>(centroids[j], rows[i]);
+                if (dj < best) {
+                    best = dj;
+                    min = j;
+                }
+            }
+            labels[i] = min;
+            nearest[i] = std::sqrt(static_cast<double>(best));
+        }
+        return;
+#endif
+        std::array<std::int64_t, ROW_TILE> best;
+        std::array<int, ROW_TILE> bestIndex;
+
+        for (int r0 = lo; r0 < hi; r0 += ROW_TILE) {
+            const int rows_n = std::min(ROW_TILE, hi - r0);
+            best.fill(INT64_MAX);
+            bestIndex.fill(0);
+
+            for (int c0 = 0; c0 < PADDED_K; c0 += CENTROID_TILE) {
+                const int c1 = std::min(PADDED_K, c0 + CENTROID_TILE);
+                for (int r = 0; r < rows_n; r += 2) {
+                    // an odd last row is paired with itself and the duplicate is ignored
+                    const int i0 = r0 + r;
+                    const int i1 = r + 1 < rows_n ? i0 + 1 : i0;
+                    for (int c = c0; c < c1; c += 4) {
+                        std::int64_t dot[2][4];
+                        dot2x4(i0, i1, c, dot);
+                        for (int q = 0; q < 4; q++) {
+                            const std::int64_t d0 = rowNorms[i0] + centroidNorms[c + q] - 2 * dot[0][q];
+                            if (d0 < best[r]) {
+                                best[r] = d0;
+                                bestIndex[r] = c + q;
+                            }
+                            if (i1 != i0) {
+                                const std::int64_t d1 = rowNorms[i1] + centroidNorms[c + q] - 2 * dot[1][q];
+                                if (d1 < best[r + 1]) {
+                                    best[r + 1] = d1;
+                                    bestIndex[r + 1] = c + q;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            for (int r = 0; r < rows_n; r++) {
+                labels[r0 + r] = bestIndex[r];
+                nearest[r0 + r] = std::sqrt(static_cast<double>(best[r]));
+            }
+        }
+    }
+
+private:
+    /** k rounded up to the micro-kernel's 4 centroids. */
+    static constexpr int PADDED_K = (k + 3) / 4 * 4;
+    /** Norm of a padding centroid; larger than any real squared distance. */
+    static constexpr std::int64_t UNREACHABLE = INT64_MAX / 4;
+
+    const Element *rows = nullptr;
+    int m = 0;
+    std::vector<std::int64_t> rowNorms;                 // rowNorms[i] = ||rows[i]||^2
+    std::vector<std::int64_t> rowSums;                  // rowSums[i] = sum of the bytes of rows[i]
+    std::array<Element, PADDED_K> centroids;            // contiguous copy of the centroids
+    std::array<std::array<std::int8_t,d>, PADDED_K> biased;  // biased[j][dim] = centroids[j][dim] - 128
+    std::array<std::int64_t, PADDED_K> centroidNorms;   // centroidNorms[j] = ||centroids[j]||^2
+
+    /**
+     * Micro-kernel: dot products of two rows with four consecutive centroids.
+     * @param i0 index of one row
+     * @param i1 index of another row
+     * @param c first of the four centroids
+     * @param dot dot[r][q] is set to x_r . centroids[c + q]
+     */
+    void dot2x4(int i0, int i1, int c, std::int64_t dot[2][4]) const {
+        const u_char *a0 = rows[i0].data(), *a1 = rows[i1].data();
+        const u_char *b0 = centroids[c].data(), *b1 = centroids[c + 1].data();
+        const u_char *b2 = centroids[c + 2].data(), *b3 = centroids[c + 3].data();
+        std::int64_t sums[2][4] = {};
+#if defined(BLOCKED_DISTANCES_VNNI) || defined(__AVX2__)
+        // the vector loops cover [0, vectorEnd); the scalar loop covers the rest
+        constexpr int vectorEnd = d / 16 * 16;
+#else
+        constexpr int vectorEnd = 0;
+#endif
+#if defined(BLOCKED_DISTANCES_VNNI)
+        // each lane gains at most 4 * 255 * 128 per step, so d up to 500000 cannot overflow
+        __m256i acc00 = _mm256_setzero_si256(), acc01 = _mm256_setzero_si256();
+        __m256i acc02 = _mm256_setzero_si256(), acc03 = _mm256_setzero_si256();
+        __m256i acc10 = _mm256_setzero_si256(), acc11 = _mm256_setzero_si256();
+        __m256i acc12 = _mm256_setzero_si256(), acc13 = _mm256_setzero_si256();
+        const std::int8_t *s0 = biased[c].data(), *s1 = biased[c + 1].data();
+        const std::int8_t *s2 = biased[c + 2].data(), *s3 = biased[c + 3].data();
+        for (int i = 0; i < d / 32 * 32; i += 32) {
+            const __m256i r0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a0 + i));
+            const __m256i r1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a1 + i));
+            __m256i cq = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s0 + i));
+            acc00 = BLOCKED_DISTANCES_DPBUSD(acc00, r0, cq);
+            acc10 = BLOCKED_DISTANCES_DPBUSD(acc10, r1, cq);
+            cq = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s1 + i));
+            acc01 = BLOCKED_DISTANCES_DPBUSD(acc01, r0, cq);
+            acc11 = BLOCKED_DISTANCES_DPBUSD(acc11, r1, cq);
+            cq = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s2 + i));
+            acc02 = BLOCKED_DISTANCES_DPBUSD(acc02, r0, cq);
+            acc12 = BLOCKED_DISTANCES_DPBUSD(acc12, r1, cq);
+            cq = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s3 + i));
+            acc03 = BLOCKED_DISTANCES_DPBUSD(acc03, r0, cq);
+            acc13 = BLOCKED_DISTANCES_DPBUSD(acc13, r1, cq);
+        }
+        if constexpr (d % 32 >= 16) {
+            // a last half step: the zeroed upper row bytes contribute nothing
+            constexpr int i = d / 32 * 32;
+            const __m256i r0 = _mm256_zextsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a0 + i)));
+            const __m256i r1 = _mm256_zextsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a1 + i)));
+            __m256i cq = _mm256_zextsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s0 + i)));
+            acc00 = BLOCKED_DISTANCES_DPBUSD(acc00, r0, cq);
+            acc10 = BLOCKED_DISTANCES_DPBUSD(acc10, r1, cq);
+            cq = _mm256_zextsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s1 + i)));
+            acc01 = BLOCKED_DISTANCES_DPBUSD(acc01, r0, cq);
+            acc11 = BLOCKED_DISTANCES_DPBUSD(acc11, r1, cq);
+            cq = _mm256_zextsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s2 + i)));
+            acc02 = BLOCKED_DISTANCES_DPBUSD(acc02, r0, cq);
+            acc12 = BLOCKED_DISTANCES_DPBUSD(acc12, r1, cq);
+            cq = _mm256_zextsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s3 + i)));
+            acc03 = BLOCKED_DISTANCES_DPBUSD(acc03, r0, cq);
+            acc13 = BLOCKED_DISTANCES_DPBUSD(acc13, r1, cq);
+        }
+        const __m256i accs[2][4] = {{acc00, acc01, acc02, acc03}, {acc10, acc11, acc12, acc13}};
+        for (int r = 0; r < 2; r++) {
+            for (int q = 0; q < 4; q++) {
+                sums[r][q] = horizontalSum(accs[r][q]);
+            }
+        }
+        // undo the bias over [0, vectorEnd): x.c = x.(c - 128) + 128 sum(x)
+        if constexpr (vectorEnd > 0) {
+            std::int64_t prefix0 = rowSums[i0], prefix1 = rowSums[i1];
+            for (int t = vectorEnd; t < d; t++) {
+                prefix0 -= a0[t];
+                prefix1 -= a1[t];
+            }
+            for (int q = 0; q < 4; q++) {
+                sums[0][q] += 128 * prefix0;
+                sums[1][q] += 128 * prefix1;
+            }
+        }
+#elif defined(__AVX2__)
+        // bytes widened to 16 bits, multiplied and pair-summed into 32-bit lanes;
+        // each lane gains at most 2 * 255^2 per step, so d up to 16000 cannot overflow
+        __m256i acc[2][4];
+        for (int r = 0; r < 2; r++)
+            for (int q = 0; q < 4; q++)
+                acc[r][q] = _mm256_setzero_si256();
+        const u_char *bs[4] = {b0, b1, b2, b3};
+        for (int i = 0; i < vectorEnd; i += 16) {
+            const __m256i r0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a0 + i)));
+            const __m256i r1 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a1 + i)));
+            for (int q = 0; q < 4; q++) {
+                const __m256i cq = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bs[q] + i)));
+                acc[0][q] = _mm256_add_epi32(acc[0][q], _mm256_madd_epi16(r0, cq));
+                acc[1][q] = _mm256_add_epi32(acc[1][q], _mm256_madd_epi16(r1, cq));
+            }
+        }
+        for (int r = 0; r < 2; r++) {
+            for (int q = 0; q < 4; q++) {
+                sums[r][q] = horizontalSum(acc[r][q]);
+            }
+        }
+#endif
+        for (int i = vectorEnd; i < d; i++) {
+            sums[0][0] += a0[i] * b0[i];
+            sums[0][1] += a0[i] * b1[i];
+            sums[0][2] += a0[i] * b2[i];
+            sums[0][3] += a0[i] * b3[i];
+            sums[1][0] += a1[i] * b0[i];
+            sums[1][1] += a1[i] * b1[i];
+            sums[1][2] += a1[i] * b2[i];
+            sums[1][3] += a1[i] * b3[i];
+        }
+        for (int r = 0; r < 2; r++)
+            for (int q = 0; q < 4; q++)
+                dot[r][q] = sums[r][q];
+    }
+
+#if defined(__AVX2__)
+    /**
+     * @param v eight 32-bit lanes
+     * @return sum of the lanes, as a signed 32-bit value
+     */
+    static std::int64_t horizontalSum(__m256i v) {
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(half);
+    }
+#endif
+};
@@ -6,6 +6,7 @@
 #pragma once
 #include "KMeans.h"
 #include "Color.h"
+#include "DistanceKernels.h"
 
 template <int k>
 class ColorKMeans : public KMeans<k,3> {
@@ -24,11 +25,22 @@ protected:
     /**
      * We supply the distance method to the abstract KMeans class
      * We use the Euclidean distance between the colors interpreted as 3-d vectors in R,G,B space
+     * (the same value as Color::euclidDistance, without building Color temporaries)
      * @param a one color
      * @param b and another
      * @return distance between a and b; 0.0 <= distance <= 441.67 (sqrt(255^2 + 255^2 + 255^2))
      */
     double distance(const Element& a, const Element& b) const override {
-        return Color(a).euclidDistance(Color(b));
+        return DistanceKernels::euclidean<3>(a, b);
+    }
+
+    /**
+     * Closest centroid by squared distance, with no virtual call per pair.
+     * @param e color to place
+     * @param dist set to the distance from e to the closest centroid
+     * @return index of the closest centroid
+     */
+    int closestCluster(const Element& e, double& dist) const override {
+        return DistanceKernels::closest<3>(this->clusters, e, dist);
     }
 };
@@ -0,0 +1,53 @@
+/**
+ * @file ColorKMeansThreaded.h - a subclass of KMeansThreaded to cluster Color objects
+ * @author Junwen Zheng
+ * @date Feb 15, 2026
+ */
+#pragma once
+#include <thread>
+#include "KMeansThreaded.h"
+#include "Color.h"
+#include "DistanceKernels.h"
+
+template <int k>
+class ColorKMeansThreaded : public KMeansThreaded<k,3> {
+public:
+    /**
+     * @param nThreads number of threads to cluster with; defaults to every hardware thread
+     */
+    explicit ColorKMeansThreaded(int nThreads = static_cast<int>(std::thread::hardware_concurrency()))
+        : KMeansThreaded<k,3>(nThreads) {}
+
+    void fit(Color *colors, int n) {
+        // We know that a Color is actually just an array of three bytes so the cast is ok
+        // NOTE: this will stop working correctly if the Color data layout is changed in any way
+        KMeansThreaded<k,3>::fit(reinterpret_cast<std::array<u_char,3> *>(colors), n);
+    }
+
+private:
+    using KMeansThreaded<k, 3>::fit;
+
+protected:
+    typedef std::array<u_char,3> Element;
+    /**
+     * We supply the distance method to the abstract KMeansThreaded class
+     * We use the Euclidean distance between the colors interpreted as 3-d vectors in R,G,B space
+     * (the same value as Color::euclidDistance, without building Color temporaries)
+     * @param a one color
+     * @param b and another
+     * @return distance between a and b; 0.0 <= distance <= 441.67 (sqrt(255^2 + 255^2 + 255^2))
+     */
+    double distance(const Element& a, const Element& b) const override {
+        return DistanceKernels::euclidean<3>(a, b);
+    }
+
+    /**
+     * Closest centroid by squared distance, with no virtual call per pair.
+     * @param e color to place
+     * @param dist set to the distance from e to the closest centroid
+     * @return index of the closest centroid
+     */
+    int closestCluster(const Element& e, double& dist) const override {
+        return DistanceKernels::closest<3>(this->clusters, e, dist);
+    }
+};
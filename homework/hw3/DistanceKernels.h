@@ -0,0 +1,124 @@
+/**
+* @file DistanceKernels.h - squared Euclidean distance kernels for byte-vector elements
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#pragma once  // only process the first time it is included; ignore otherwise
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <sys/types.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Distance kernels specialized at compile time on the element width d.
+ *
+ * Squared distances are exact 32-bit integers (d * 255^2 fits for any d below 66000),
+ * so comparing them picks the same closest centroid as comparing Euclidean distances
+ * without taking a square root per pair.
+ *
+ * For d >= 16 the differences are vectorized: |a - b| per byte is the saturating
+ * difference taken both ways and or'ed together, which is then widened to 16 bits and
+ * squared-and-pair-summed into 32-bit lanes with pmaddwd. There is an AVX2 path (32 bytes
+ * per step), an SSE2 path (16 bytes per step) and a scalar tail/fallback, chosen from
+ * the target flags (see -march in the Makefile). Short elements such as colors (d = 3)
+ * use the scalar loop, which the compiler fully unrolls.
+ */
+namespace DistanceKernels {
+
+/**
+ * Squared Euclidean distance between two byte vectors.
+ * @param a one element
+ * @param b another element
+ * @return sum over i of (a[i] - b[i])^2
+ */
+template <int d>
+inline std::uint32_t squaredL2(const std::array<u_char,d>& a, const std::array<u_char,d>& b) {
+    // the vector loops cover [0, vectorEnd); the scalar loop covers the rest
+    constexpr int vectorEnd = d / 16 * 16;
+    std::uint32_t sum = 0;
+    if constexpr (vectorEnd > 0) {
+#if defined(__AVX2__)
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i acc = _mm256_setzero_si256();
+        for (int i = 0; i < d / 32 * 32; i += 32) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.data() + i));
+            const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.data() + i));
+            const __m256i diff = _mm256_or_si256(_mm256_subs_epu8(x, y), _mm256_subs_epu8(y, x));
+            const __m256i lo = _mm256_unpacklo_epi8(diff, zero);
+            const __m256i hi = _mm256_unpackhi_epi8(diff, zero);
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(lo, lo));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(hi, hi));
+        }
+        __m128i acc128 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        constexpr int sseStart = d / 32 * 32;
+#elif defined(__SSE2__)
+        __m128i acc128 = _mm_setzero_si128();
+        constexpr int sseStart = 0;
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+        const __m128i zero128 = _mm_setzero_si128();
+        for (int i = sseStart; i < vectorEnd; i += 16) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data() + i));
+            const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + i));
+            const __m128i diff = _mm_or_si128(_mm_subs_epu8(x, y), _mm_subs_epu8(y, x));
+            const __m128i lo = _mm_unpacklo_epi8(diff, zero128);
+            const __m128i hi = _mm_unpackhi_epi8(diff, zero128);
+            acc128 = _mm_add_epi32(acc128, _mm_madd_epi16(lo, lo));
+            acc128 = _mm_add_epi32(acc128, _mm_madd_epi16(hi, hi));
+        }
+        acc128 = _mm_add_epi32(acc128, _mm_shuffle_epi32(acc128, _MM_SHUFFLE(1, 0, 3, 2)));
+        acc128 = _mm_add_epi32(acc128, _mm_shuffle_epi32(acc128, _MM_SHUFFLE(2, 3, 0, 1)));
+        sum = static_cast<std::uint32_t>(_mm_cvtsi128_si32(acc128));
+#endif
+    }
+#if defined(__AVX2__) || defined(__SSE2__)
+    constexpr int scalarStart = vectorEnd;
+#else
+    constexpr int scalarStart = 0;
+#endif
+    for (int i = scalarStart; i < d; i++) {
+        const int diff = static_cast<int>(a[i]) - static_cast<int>(b[i]);
+        sum += static_cast<std::uint32_t>(diff * diff);
+    }
+    return sum;
+}
+
+/**
+ * Euclidean distance between two byte vectors.
+ * @param a one element
+ * @param b another element
+ * @return sqrt of squaredL2(a, b)
+ */
+template <int d>
+inline double euclidean(const std::array<u_char,d>& a, const std::array<u_char,d>& b) {
+    return std::sqrt(static_cast<double>(squaredL2<d>(a, b)));
+}
+
+/**
+ * Find the centroid closest to e by squared distance, with one square root at the end.
+ * Ties go to the lowest index, as in KMeans::closestCluster.
+ * @param clusters k clusters, each with a centroid member
+ * @param e the element to place
+ * @param dist set to the Euclidean distance from e to the closest centroid
+ * @return index of the closest centroid
+ */
+template <int d, typename Clusters>
+inline int closest(const Clusters& clusters, const std::array<u_char,d>& e, double& dist) {
+    int min = 0;
+    std::uint32_t best = squaredL2<d>(clusters[0].centroid, e);
+    for (int j = 1; j < static_cast<int>(clusters.size()); j++) {
+        const std::uint32_t dj = squaredL2<d>(clusters[j].centroid, e);
+        if (dj < best) {
+            best = dj;
+            min = j;
+        }
+    }
+    dist = std::sqrt(static_cast<double>(best));
+    return min;
+}
+
+}  // namespace DistanceKernels
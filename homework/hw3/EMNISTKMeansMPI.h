@@ -3,6 +3,8 @@
 #pragma once
 
 #include "KMeansMPI.h"
+#include "BlockedDistances.h"
+#include "DistanceKernels.h"
 #include <array>
 #include <cmath>
 #include <cstddef>
@@ -40,6 +42,46 @@ private:
     using KMeansMPI<k, 784>::fit;
 
 protected:
+    /**
+     * Tiled distance engine over this rank's partition (see BlockedDistances.h).
+     */
+    BlockedDistances<k, 784> blocked;
+
+    /**
+     * Once this rank's images are in place (scattered or loaded by the rank itself), compute
+     * each local image's squared norm once for the blocked distance engine.
+     */
+    void partitionLoaded() override {
+        blocked.setRows(this->partition, this->m);
+    }
+
+    /**
+     * Load this generation's centroids into the blocked engine (their norms are computed
+     * once here, not per range).
+     */
+    void prepareAssignment() override {
+        if (!this->pruning) {
+            blocked.setCentroids(this->clusters);
+        }
+    }
+
+    /**
+     * Assign local images [lo, hi) to their closest centroids with the blocked engine: the
+     * image-centroid dot products are done as a cache-tiled, register-blocked matrix product.
+     * The pruned mode uses the base class's bounded assignment instead.
+     *
+     * @param lo first local image
+     * @param hi one past the last local image
+     * @return number of distance evaluations made
+     */
+    long assignRange(int lo, int hi) override {
+        if (this->pruning) {
+            return KMeansMPI<k, 784>::assignRange(lo, hi);
+        }
+        blocked.assign(lo, hi, this->labels.data(), this->nearest.data());
+        return static_cast<long>(hi - lo) * k;
+    }
+
     /**
      * Compute the distance between two digit images.
      *
@@ -48,13 +90,20 @@ protected:
      * @return Euclidean distance between a and b
      */
     double distance(const Element& a, const Element& b) const override {
-        double sum = 0.0;
-
-        for (int i = 0; i < 784; ++i) {
-            const double diff = static_cast<double>(a[i]) - static_cast<double>(b[i]);
-            sum += diff * diff;
-        }
+        return DistanceKernels::euclidean<784>(a, b);
+    }
 
-        return std::sqrt(sum);
+    /**
+     * Find the closest centroid to a digit image.
+     *
+     * Compares exact integer squared distances from the SIMD kernel, so there is no
+     * square root or virtual call per (image, centroid) pair.
+     *
+     * @param e digit image to place
+     * @param dist set to the Euclidean distance from e to the closest centroid
+     * @return index of the closest centroid
+     */
+    int closestCluster(const Element& e, double& dist) const override {
+        return DistanceKernels::closest<784>(this->clusters, e, dist);
     }
 };
\ No newline at end of file
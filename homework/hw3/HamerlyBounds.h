@@ -0,0 +1,174 @@
+/**
+* @file HamerlyBounds.h - triangle-inequality bounds for skipping k-means distance evaluations
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#pragma once  // only process the first time it is included; ignore otherwise
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * Hamerly's pruned assignment step for k-means.
+ *
+ * For every element the bounds keep
+ *  - upper[i] >= distance to its assigned centroid, and
+ *  - lower[i] <= distance to every other centroid.
+ * When a generation moves centroid j by shift[j], the upper bound grows by the shift of the
+ * element's own centroid and the lower bound shrinks by the largest shift of any other
+ * centroid. Together with half[j] (half the distance from centroid j to its nearest other
+ * centroid), the triangle inequality proves an element keeps its centroid whenever
+ * upper[i] < max(lower[i], half[labels[i]]), and then no distance needs computing at all.
+ * Otherwise upper[i] is tightened with one distance and, only if that is not enough, all
+ * k distances are computed and both bounds reset.
+ *
+ * The test is strict, so the labels are exactly those a full assignment would produce,
+ * including its lowest-index tie rule. Bounds need a true metric (the triangle
+ * inequality), so the engines pass their distance(), not a squared distance.
+ *
+ * Hamerly's single lower bound is used rather than Elkan's k lower bounds: memory stays
+ * O(n) and, for the small k these engines use, it prunes nearly as well.
+ *
+ * Template parameters:
+ *  - k: number of clusters
+ *  - d: dimensionality (bytes per element)
+ */
+template <int k, int d>
+class HamerlyBounds {
+public:
+    typedef std::array<u_char,d> Element;
+
+    /**
+     * Forget all bounds; the next assign() computes every distance for every element.
+     * @param count number of elements the bounds cover
+     */
+    void reset(int count) {
+        upper.assign(count, 0.0);
+        lower.assign(count, 0.0);
+        valid.assign(count, false);
+        shift.fill(0.0);
+        half.fill(0.0);
+    }
+
+    /**
+     * Record how far each centroid moved between two generations, to be applied to the
+     * bounds during the next assign(), and the half-distances between the new centroids.
+     * @param before clusters used by the latest assign()
+     * @param after clusters the next assign() will use
+     * @param distance metric, as a callable (const Element&, const Element&) -> double
+     */
+    template <typename Clusters, typename Distance>
+    void centroidsMoved(const Clusters& before, const Clusters& after, Distance distance) {
+        maxShift = secondShift = 0.0;
+        farthest = 0;
+        for (int j = 0; j < k; j++) {
+            shift[j] = distance(before[j].centroid, after[j].centroid);
+            if (shift[j] > maxShift) {
+                secondShift = maxShift;
+                maxShift = shift[j];
+                farthest = j;
+            } else if (shift[j] > secondShift) {
+                secondShift = shift[j];
+            }
+        }
+
+        half.fill(std::numeric_limits<double>::infinity());
+        for (int j = 0; j < k; j++) {
+            for (int jj = j + 1; jj < k; jj++) {
+                const double h = 0.5 * distance(after[j].centroid, after[jj].centroid);
+                half[j] = std::min(half[j], h);
+                half[jj] = std::min(half[jj], h);
+            }
+        }
+    }
+
+    /**
+     * Assign elements [lo, hi) to their closest centroids, skipping the distances the
+     * bounds prove unnecessary. Different threads may assign disjoint ranges at once.
+     * @param elements the elements the bounds cover
+     * @param lo first element
+     * @param hi one past the last element
+     * @param clusters current clusters
+     * @param distance metric, as a callable (const Element&, const Element&) -> double
+     * @param labels labels[i] is the element's centroid (read for bounded elements, written for all)
+     * @param nearest nearest[i] is set to the distance to the assigned centroid (an upper
+     *                bound on it for elements that were skipped)
+     * @return number of distance evaluations made
+     */
+    template <typename Clusters, typename Distance>
+    long assign(const Element *elements, int lo, int hi, const Clusters& clusters,
+                Distance distance, std::uint32_t *labels, double *nearest) {
+        long evaluations = 0;
+        for (int i = lo; i < hi; i++) {
+            const Element& x = elements[i];
+            if (!valid[i]) {
+                evaluations += fullScan(x, i, clusters, distance, labels, -1, 0.0);
+                valid[i] = true;
+            } else {
+                const int a = labels[i];
+                upper[i] += shift[a];
+                lower[i] -= a == farthest ? secondShift : maxShift;
+                const double bound = std::max(lower[i], half[a]);
+                if (upper[i] >= bound) {
+                    // tighten the upper bound, then check every centroid only if still needed
+                    upper[i] = distance(clusters[a].centroid, x);
+                    evaluations++;
+                    if (upper[i] >= bound) {
+                        evaluations += fullScan(x, i, clusters, distance, labels, a, upper[i]);
+                    }
+                }
+            }
+            nearest[i] = upper[i];
+        }
+        return evaluations;
+    }
+
+private:
+    std::vector<double> upper;   // upper[i] >= distance from element i to its assigned centroid
+    std::vector<double> lower;   // lower[i] <= distance from element i to any other centroid
+    std::vector<char> valid;     // valid[i] is 0 until element i's bounds are first set (char so threads can set neighbours)
+    std::array<double,k> shift;  // shift[j] is how far centroid j moved since the latest assign()
+    std::array<double,k> half;   // half[j] is half the distance from centroid j to its nearest other centroid
+    double maxShift = 0.0;       // largest shift
+    double secondShift = 0.0;    // second-largest shift
+    int farthest = 0;            // index of the centroid with the largest shift
+
+    /**
+     * Compute the distance from x to every centroid and reset both of its bounds.
+     * @param known index of a centroid whose distance is already known, or -1
+     * @param knownDistance that distance
+     * @return number of distance evaluations made
+     */
+    template <typename Clusters, typename Distance>
+    long fullScan(const Element& x, int i, const Clusters& clusters, Distance distance,
+                  std::uint32_t *labels, int known, double knownDistance) {
+        long evaluations = 0;
+        int min = 0;
+        double best = std::numeric_limits<double>::infinity();
+        double second = std::numeric_limits<double>::infinity();
+        for (int j = 0; j < k; j++) {
+            double dj;
+            if (j == known) {
+                dj = knownDistance;
+            } else {
+                dj = distance(clusters[j].centroid, x);
+                evaluations++;
+            }
+            if (dj < best) {
+                second = best;
+                best = dj;
+                min = j;
+            } else if (dj < second) {
+                second = dj;
+            }
+        }
+        labels[i] = min;
+        upper[i] = best;
+        lower[i] = second;
+        return evaluations;
+    }
+};
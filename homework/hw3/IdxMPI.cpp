@@ -0,0 +1,103 @@
+/**
+* @file IdxMPI.cpp - Implementation of loading one rank's share of an IDX file with MPI-IO
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#include "IdxMPI.h"
+#include <algorithm>
+#include <stdexcept>
+#include <sstream>
+
+/** Size in bytes of an idx3 header: magic, count, rows and cols. */
+constexpr int kIdx3Header = 16;
+
+/**
+ * Decode a 32-bit unsigned integer stored in big-endian order.
+ *
+ * @param b the 4 bytes of the integer
+ * @return decoded 32-bit unsigned integer
+ */
+static std::uint32_t decode_be_u32(const std::uint8_t *b) {
+    return (std::uint32_t(b[0]) << 24) |
+           (std::uint32_t(b[1]) << 16) |
+           (std::uint32_t(b[2]) <<  8) |
+            std::uint32_t(b[3]);
+}
+
+/**
+ * Read this rank's share of an idx3 image file with collective MPI-IO.
+ *
+ * Every rank validates the header itself, so on a malformed file all of them throw.
+ *
+ * @param path filesystem path to the idx3-ubyte image file
+ * @param comm communicator whose ranks share the file
+ * @return IdxPartition with this rank's images
+ * @throws std::runtime_error if the file cannot be opened or is malformed
+ */
+IdxPartition read_idx3_partition(const std::string &path, MPI_Comm comm) {
+    int rank, p;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &p);
+
+    MPI_File file;
+    if (MPI_File_open(comm, path.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+        throw std::runtime_error("Could not open file.");
+    }
+
+    // Read dataset metadata
+    std::uint8_t header[kIdx3Header];
+    MPI_Status status;
+    int got = 0;
+    MPI_File_read_at_all(file, 0, header, kIdx3Header, MPI_BYTE, &status);
+    MPI_Get_count(&status, MPI_BYTE, &got);
+    if (got != kIdx3Header) {
+        MPI_File_close(&file);
+        throw std::runtime_error("Malformed input file.");
+    }
+
+    const std::uint32_t magic = decode_be_u32(header);
+    if (magic != 2051) {
+        MPI_File_close(&file);
+        std::ostringstream oss;
+        oss << "Bad magic for idx3 images. Got " << magic;
+        throw std::runtime_error(oss.str());
+    }
+
+    const std::uint32_t count = decode_be_u32(header + 4);
+    const std::uint32_t rows  = decode_be_u32(header + 8);
+    const std::uint32_t cols  = decode_be_u32(header + 12);
+
+    // Expected image dimensions
+    if (rows != kRows || cols != kCols) {
+        MPI_File_close(&file);
+        std::ostringstream oss;
+        oss << "Malformed image shape. Expected 28x28, got "
+            << rows << "x" << cols;
+        throw std::runtime_error(oss.str());
+    }
+
+    // This rank's range of images: even shares, one extra for each of the first count % p ranks
+    IdxPartition out;
+    out.count = static_cast<int>(count);
+    const int share = out.count / p;
+    const int extra = out.count % p;
+    out.first = rank * share + std::min(rank, extra);
+    out.images.resize(share + (rank < extra ? 1 : 0));
+
+    // Read image data, counted in whole images so large shares stay within an int count
+    MPI_Datatype imageType;
+    MPI_Type_contiguous(kDim, MPI_BYTE, &imageType);
+    MPI_Type_commit(&imageType);
+    const MPI_Offset offset = kIdx3Header + static_cast<MPI_Offset>(out.first) * kDim;
+    const int wanted = static_cast<int>(out.images.size());
+    MPI_File_read_at_all(file, offset, out.images.data(), wanted, imageType, &status);
+    MPI_Get_count(&status, imageType, &got);
+    MPI_Type_free(&imageType);
+    MPI_File_close(&file);
+
+    if (got != wanted) {
+        throw std::runtime_error("Malformed image bytes");
+    }
+    return out;
+}
@@ -0,0 +1,40 @@
+/**
+* @file IdxMPI.h - header file for loading one rank's share of an IDX file with MPI-IO
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#pragma once
+#include "IdxIO.h"
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+/**
+ * One rank's contiguous share of the images in an image file.
+ *
+ * Fields:
+ *  - count: number of images in the whole file
+ *  - first: index (in the file) of this rank's first image
+ *  - images: this rank's images, first .. first + images.size() - 1
+ */
+struct IdxPartition {
+    int count = 0;              // number of images in the whole file
+    int first = 0;              // file index of images[0]
+    std::vector<Image> images;  // this rank's images
+};
+
+/**
+ * Read this rank's share of an image file; every rank of comm must call it.
+ *
+ * Each rank reads the 16-byte header, then only its own byte range of image data, with
+ * collective MPI-IO reads (MPI_File_read_at_all), so no rank holds or forwards the whole
+ * file. The n images are split in rank order as evenly as possible: the first n % p ranks
+ * get one extra image.
+ *
+ * @param path path to the idx3-ubyte image file
+ * @param comm communicator whose ranks share the file
+ * @return IdxPartition with this rank's images
+ * @throws std::runtime_error if the file cannot be opened or is malformed
+ */
+IdxPartition read_idx3_partition(const std::string &path, MPI_Comm comm);
@@ -10,6 +10,13 @@
 #include <iostream>
 #include <set>
 #include <array>
+#include <cstdint>
+#include <optional>
+#include "HamerlyBounds.h"
+#include "Membership.h"
+#include "RunningSums.h"
+#include "MiniBatch.h"
+#include "Seeding.h"
 
 template <int k, int d>
 class KMeans {
@@ -32,14 +39,92 @@ public:
         return clusters;
     }
 
+    /**
+     * Expose the final assignments to the client readonly.
+     * @return labels[i] is the cluster of element i, from latest call to fit()
+     */
+    const std::vector<std::uint32_t>& getLabels() const {
+        return labels;
+    }
+
+    /**
+     * Expose the final membership, grouped by cluster, to the client readonly.
+     * @return members of each cluster in one index array, from latest call to fit()
+     */
+    const Membership& getMembership() const {
+        return membership;
+    }
+
+    /**
+     * Turn the pruned assignment mode on or off for later calls to fit().
+     * When on, triangle-inequality bounds (see HamerlyBounds.h) skip the distance evaluations
+     * that cannot change an element's cluster; the clustering is the same either way.
+     * @param on true to prune
+     */
+    void setPruning(bool on) {
+        pruning = on;
+    }
+
+    /**
+     * Turn the incremental centroid update on or off for later calls to fit().
+     * When on, per-cluster integer sums persist across generations and only elements whose
+     * label changed are moved between them (see RunningSums.h); each centroid is then the
+     * exact mean of its elements, truncated to bytes once, rather than the running byte
+     * average accum() builds. A cluster left empty keeps its previous centroid (as in
+     * KMeansMPI), where the full pass resets it to all zeros.
+     * @param on true to update incrementally
+     */
+    void setIncremental(bool on) {
+        incremental = on;
+    }
+
+    /**
+     * Switch later calls to fit() between full passes and mini-batch steps.
+     * In mini-batch mode each step assigns a random sample of the elements and moves only the
+     * centroids it touched (see MiniBatch.h); a single full assignment pass then sets the
+     * final membership.
+     * @param size elements sampled per step; 0 turns mini-batch mode off (the default)
+     * @param steps number of mini-batch steps
+     */
+    void setMiniBatch(int size, int steps) {
+        batchSize = size;
+        batchSteps = steps;
+    }
+
+    /**
+     * Fix the random seed of later calls to fit() (seeding and mini-batch sampling), so that a run
+     * can be reproduced and the modes compared; by default every fit() draws a new seed from
+     * std::random_device.
+     * @param value seed
+     */
+    void setSeed(unsigned value) {
+        seed = value;
+    }
+
+    /**
+     * Number of element-to-centroid distances evaluated by the latest call to fit().
+     * @return distance evaluations (n * k per generation without pruning)
+     */
+    long getDistanceCalls() const {
+        return distanceCalls;
+    }
+
     /**
      * fit() is the main k-means algorithm
     */
     virtual void fit(const Element *data, int data_n) {
         elements = data;
         n = data_n;
-        dist.resize(n);
+        labels.resize(n);
+        nearest.resize(n);
+        distanceCalls = 0;
+        bounds.reset(n);
+        running.reset();
         reseedClusters();
+        if (batchSize > 0) {
+            fitMiniBatch();
+            return;
+        }
         Clusters prior = clusters;
         prior[0].centroid[0]++;  // just to make it different the first time
         int generation = 0;
@@ -47,7 +132,10 @@ public:
             updateDistances();
             prior = clusters;
             updateClusters();
+            if (pruning)
+                bounds.centroidsMoved(prior, clusters, metric());
         }
+        buildMembership();
     }
 
     /**
@@ -69,21 +157,26 @@ protected:
     const Element *elements = nullptr;       // set of elements to classify into k categories (supplied to latest call to fit())
     int n = 0;                               // number of elements in this->elements
     Clusters clusters;                       // k clusters resulting from latest call to fit()
-    std::vector<std::array<double,k>> dist;  // dist[i][j] is the distance from elements[i] to clusters[j].centroid
+    std::vector<std::uint32_t> labels;       // labels[i] is the index of the centroid closest to elements[i]
+    Membership membership;                   // elements grouped by cluster, built once after fit() converges
+    std::vector<double> nearest;             // nearest[i] is the distance from elements[i] to clusters[labels[i]].centroid
+    bool pruning = false;                    // whether updateDistances() uses bounds (see setPruning())
+    HamerlyBounds<k,d> bounds;               // per-element distance bounds for the pruned mode
+    long distanceCalls = 0;                  // distance evaluations so far in the latest fit()
+    bool incremental = false;                // whether updateClusters() uses running (see setIncremental())
+    RunningSums<k,d> running;                // per-cluster sums kept across generations for the incremental mode
+    int batchSize = 0;                       // elements per mini-batch step; 0 for full passes (see setMiniBatch())
+    int batchSteps = 0;                      // number of mini-batch steps
+    std::optional<unsigned> seed;            // fixed random seed, if any (see setSeed())
 
     /**
      * Get the initial cluster centroids.
-     * Default implementation here is to just pick k elements at random from the element
-     * set
-     * @return list of clusters made by using k random elements as the initial centroids
+     * Default implementation here is k-means++ (see Seeding.h): k elements chosen one at a
+     * time, each in proportion to its squared distance from the ones already chosen
      */
     virtual void reseedClusters() {
-        std::vector<int> seeds;
-        std::vector<int> candidates(n);
-        std::iota(candidates.begin(), candidates.end(), 0);
-        auto random = std::mt19937{std::random_device{}()};
-        // Note that we need C++20 for std::sample
-        std::sample(candidates.begin(), candidates.end(), back_inserter(seeds), k, random);
+        auto random = Seeding::makeRandom(seed);
+        std::vector<int> seeds = Seeding::kMeansPlusPlus<k,d>(elements, nullptr, n, metric(), random, distanceCalls);
         for (int i = 0; i < k; i++) {
             clusters[i].centroid = elements[seeds[i]];
             clusters[i].elements.clear();
@@ -91,40 +184,136 @@ protected:
     }
 
     /**
-     * Calculate the distance from each element to each centroid.
-     * Place into this->dist which is a k-vector of distances from each element to the kth centroid.
+     * Find the closest centroid to each element (see closestCluster).
+     * Place the closest centroid's index into this->labels and its distance into this->nearest,
+     * so no n-by-k distance table is ever stored.
+     * In the pruned mode, only the distances the bounds cannot rule out are evaluated.
      */
     virtual void updateDistances() {
+        if (pruning) {
+            distanceCalls += bounds.assign(elements, 0, n, clusters, metric(), labels.data(), nearest.data());
+            return;
+        }
+        distanceCalls += static_cast<long>(n) * k;
         for (int i = 0; i < n; i++) {
             V(cout<<"distances for "<<i<<"(";for(int x=0;x<d;x++)printf("%02x",elements[i][x]);)
-            for (int j = 0; j < k; j++) {
-                dist[i][j] = distance(clusters[j].centroid, elements[i]);
-                V(cout<<" " << dist[i][j];)
-            }
-            V(cout<<endl;)
+            labels[i] = closestCluster(elements[i], nearest[i]);
+            V(cout<<" closest "<<labels[i]<<" at "<<nearest[i]<<endl;)
         }
     }
 
     /**
-     * Recalculate the current clusters based on the new distances shown in this->dist.
+     * Recalculate the current clusters' centroids based on the new assignments shown in this->labels.
+     * Membership lists are left alone until buildMembership().
+     * In the incremental mode, only the elements that changed cluster are visited, and an
+     * empty cluster keeps its previous centroid instead of being reset to zeros.
      */
     virtual void updateClusters() {
+        if (incremental) {
+            running.update(elements, labels.data(), n);
+            for (int j = 0; j < k; j++) {
+                const int count = running.count(j);
+                if (count > 0) {
+                    const std::int64_t *sum = running.sum(j);
+                    for (int dim = 0; dim < d; dim++) {
+                        clusters[j].centroid[dim] = static_cast<u_char>(sum[dim] / count);
+                    }
+                }
+            }
+            return;
+        }
         // reinitialize all the clusters
+        std::array<int,k> counts{};
         for (int j = 0; j < k; j++) {
             clusters[j].centroid = Element{};
-            clusters[j].elements.clear();
         }
-        // for each element, put it in its closest cluster (updating the cluster's centroid as we go)
+        // for each element, fold it into its closest cluster's centroid
         for (int i = 0; i < n; i++) {
-            int min = 0;
-            for (int j = 1; j < k; j++)
-                if (dist[i][j] < dist[i][min])
-                    min = j;
-            accum(clusters[min].centroid, clusters[min].elements.size(), elements[i], 1);
-            clusters[min].elements.push_back(i);
+            const int min = labels[i];
+            accum(clusters[min].centroid, counts[min]++, elements[i], 1);
+        }
+    }
+
+    /**
+     * Group the elements by their final labels: build the membership view with one counting
+     * sort, then fill each cluster's element list with a single allocation.
+     */
+    virtual void buildMembership() {
+        membership.build(labels.data(), n, k);
+        for (int j = 0; j < k; j++) {
+            clusters[j].elements.assign(membership.begin(j), membership.end(j));
         }
     }
 
+    /**
+     * Mini-batch replacement for the generation loop of fit(), starting from the seeded clusters.
+     * Each step samples batchSize elements (with replacement), assigns them, and applies their
+     * per-cluster counts and sums with MiniBatch::step. Then every element is assigned once
+     * (updateDistances) and the membership lists are filled; the centroids are left as the
+     * mini-batch steps put them.
+     */
+    virtual void fitMiniBatch() {
+        std::vector<double> centers(k * d);
+        std::array<long,k> seen{};
+        for (int j = 0; j < k; j++) {
+            for (int dim = 0; dim < d; dim++) {
+                centers[j * d + dim] = clusters[j].centroid[dim];
+            }
+        }
+
+        auto random = Seeding::makeRandom(seed);
+        std::uniform_int_distribution<int> pick(0, n - 1);
+        std::array<int,k> counts;
+        std::vector<double> sums(k * d);
+        for (int step = 0; step < batchSteps; step++) {
+            counts.fill(0);
+            std::fill(sums.begin(), sums.end(), 0.0);
+            for (int b = 0; b < batchSize; b++) {
+                const Element& e = elements[pick(random)];
+                double dist;
+                const int min = closestCluster(e, dist);
+                counts[min]++;
+                for (int dim = 0; dim < d; dim++) {
+                    sums[min * d + dim] += e[dim];
+                }
+            }
+            distanceCalls += static_cast<long>(batchSize) * k;
+            MiniBatch::step<k,d>(centers.data(), seen.data(), counts.data(), sums.data(), clusters);
+        }
+
+        updateDistances();
+        buildMembership();
+    }
+
+    /**
+     * Find the centroid closest to an element.
+     * This default calls distance() once per centroid; a subclass with a faster kernel for
+     * its metric can override it to replace the k virtual distance() calls per element.
+     * @param e element to place
+     * @param dist set to the distance from e to the closest centroid
+     * @return index of the closest centroid (the lowest index on ties)
+     */
+    virtual int closestCluster(const Element& e, double& dist) const {
+        int min = 0;
+        double best = distance(clusters[0].centroid, e);
+        for (int j = 1; j < k; j++) {
+            const double dj = distance(clusters[j].centroid, e);
+            if (dj < best) {
+                best = dj;
+                min = j;
+            }
+        }
+        dist = best;
+        return min;
+    }
+
+    /**
+     * @return this->distance() as a callable, for HamerlyBounds
+     */
+    auto metric() const {
+        return [this](const Element& a, const Element& b) { return distance(a, b); };
+    }
+
     /**
      * Method to update a centroid with an additional element(s)
      * @param centroid   accumulating mean of the elements in a cluster so far
@@ -0,0 +1,319 @@
+/**
+* @file KMeansDynamic.h - k-means with the number of clusters and dimensions chosen at runtime
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#pragma once  // only process the first time it is included; ignore otherwise
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+#include "Seeding.h"
+
+/**
+ * k-means over byte vectors where k and d are runtime values, for sweeping k (model
+ * selection) without compiling one KMeans<k,d> per value.
+ *
+ * Data model:
+ *  - The n elements are rows of d bytes, contiguous (row i starts at data + i*d).
+ *  - Each model's centroids are k rows of d bytes, like KMeans's Element centroids.
+ *
+ * Centroid buffer:
+ *  - Every generation, the centroids of all models still iterating are packed into one
+ *    structure-of-arrays buffer soa[dim * stride + column] (one column per centroid,
+ *    stride padded to a multiple of LANES). For one element, the squared distances to all
+ *    columns are built up one dimension at a time, LANES columns per step, which the
+ *    compiler turns into vector code for any d.
+ *  - Elements are processed ROW_TILE at a time against COL_TILE columns at a time so the
+ *    part of the buffer being read stays in cache however many centroids there are.
+ *
+ * fitMany() fits one model per requested k in the same generations: each pass over the
+ * data computes distances to every model's centroids at once, then each model takes the
+ * argmin over its own columns. A model drops out of the buffer once it converges. All
+ * models start from one greedy k-means++ run for the largest k (see Seeding.h); a model
+ * with k clusters takes its first k seeds, which are a k-means++ seeding for k.
+ *
+ * Squared distances are accumulated in 32-bit integers, which keeps twice as many lanes
+ * per vector as 64-bit ones; this bounds d by MAX_D, where 255^2 * d still fits.
+ */
+class KMeansDynamic {
+public:
+    const int MAX_FIT_STEPS = 300;
+    static constexpr int MAX_D = std::numeric_limits<std::int32_t>::max() / (255 * 255);  // 33025
+
+    /**
+     * Result of clustering with one value of k.
+     */
+    struct Model {
+        int k;                              // number of clusters
+        std::vector<u_char> centroids;      // centroids[j*d + dim] is coordinate dim of centroid j
+        std::vector<std::uint32_t> labels;  // labels[i] is the cluster of element i
+        std::vector<int> sizes;             // sizes[j] is the number of elements in cluster j
+        double inertia = 0.0;               // sum over elements of squared distance to their centroid
+        int generations = 0;                // generations run before the centroids stopped moving
+    };
+
+    /**
+     * @param d number of bytes per element, in [1, MAX_D]
+     * @throws std::runtime_error if d is out of range
+     */
+    explicit KMeansDynamic(int d) : d(d) {
+        if (d < 1 || d > MAX_D) {
+            throw std::runtime_error("KMeansDynamic needs 1 <= d <= " + std::to_string(MAX_D));
+        }
+    }
+
+    /**
+     * Fix the random seed of the k-means++ seeding in later fits, so that a run can be
+     * reproduced; by default every fit draws a new seed from std::random_device.
+     * @param value seed
+     */
+    void setSeed(unsigned value) {
+        seed = value;
+    }
+
+    /**
+     * Run k-means clustering with one value of k.
+     * @param data n rows of d bytes (owned by caller; must stay valid for the duration of fit)
+     * @param data_n number of elements
+     * @param k number of clusters
+     * @return the model
+     */
+    const Model& fit(const u_char *data, int data_n, int k) {
+        return fitMany(data, data_n, std::vector<int>{k}).front();
+    }
+
+    /**
+     * Run k-means clustering once for each requested k, sharing the passes over the data.
+     * @param data n rows of d bytes (owned by caller; must stay valid for the duration of fit)
+     * @param data_n number of elements
+     * @param ks values of k, each in [1, n]
+     * @return one model per entry of ks, in the same order
+     */
+    const std::vector<Model>& fitMany(const u_char *data, int data_n, const std::vector<int>& ks) {
+        elements = data;
+        n = data_n;
+        models.clear();
+        for (int k: ks) {
+            if (k < 1 || k > n) {
+                throw std::runtime_error("KMeansDynamic needs 1 <= k <= n");
+            }
+            Model model;
+            model.k = k;
+            model.centroids.resize(static_cast<size_t>(k) * d);
+            model.labels.resize(n);
+            model.sizes.resize(k);
+            models.push_back(std::move(model));
+        }
+        reseedModels();
+
+        active.resize(models.size());
+        for (int a = 0; a < static_cast<int>(models.size()); a++) {
+            active[a] = a;
+        }
+        for (int generation = 1; generation <= MAX_FIT_STEPS && !active.empty(); generation++) {
+            packCentroids();
+            assignElements();
+            std::vector<int> moving;
+            for (int a = 0; a < static_cast<int>(active.size()); a++) {
+                Model& model = models[active[a]];
+                model.generations = generation;
+                model.inertia = cost[a];
+                if (updateCentroids(a)) {
+                    moving.push_back(active[a]);
+                }
+            }
+            active.swap(moving);
+        }
+        return models;
+    }
+
+    /**
+     * Expose the models to the client readonly.
+     * @return models from the latest call to fit() or fitMany()
+     */
+    const std::vector<Model>& getModels() const {
+        return models;
+    }
+
+protected:
+    static constexpr int LANES = 16;     // columns per vector step (int32 lanes; a multiple of the AVX2/AVX-512 widths)
+    static constexpr int ROW_TILE = 16;  // elements per tile
+    static constexpr int COL_TILE = 64;  // columns per tile (a multiple of LANES)
+
+    int d;                               // bytes per element
+    const u_char *elements = nullptr;    // n rows of d bytes, from the latest fit
+    int n = 0;                           // number of elements
+    std::vector<Model> models;           // one model per requested k
+    std::optional<unsigned> seed;        // fixed random seed, if any (see setSeed())
+
+    std::vector<int> active;             // indices into models of the models still iterating
+    std::vector<int> firstColumn;        // firstColumn[a] is the buffer column of centroid 0 of models[active[a]]
+    int stride = 0;                      // columns per dimension in soa (padded to a multiple of LANES)
+    std::vector<std::int32_t> soa;       // soa[dim*stride + column] is coordinate dim of that column's centroid
+    std::vector<int> counts;             // counts[column] is the number of elements assigned to that centroid
+    std::vector<std::int64_t> sums;      // sums[column*d + dim] is the sum of coordinate dim over those elements
+    std::vector<double> cost;            // cost[a] is the inertia of models[active[a]] for the latest assignment
+
+    /**
+     * Squared Euclidean distance between two rows of d bytes. The 32-byte blocks have a fixed
+     * trip count so they vectorize; the rest is a scalar tail.
+     * @param a one row
+     * @param b another row
+     * @return sum over dim of (a[dim] - b[dim])^2
+     */
+    std::int32_t squaredL2(const u_char *a, const u_char *b) const {
+        constexpr int BLOCK = 32;
+        std::int32_t sum = 0;
+        int dim = 0;
+        for (; dim + BLOCK <= d; dim += BLOCK) {
+            std::int32_t block = 0;
+            for (int i = 0; i < BLOCK; i++) {
+                const std::int32_t diff = static_cast<std::int32_t>(a[dim + i]) - b[dim + i];
+                block += diff * diff;
+            }
+            sum += block;
+        }
+        for (; dim < d; dim++) {
+            const std::int32_t diff = static_cast<std::int32_t>(a[dim]) - b[dim];
+            sum += diff * diff;
+        }
+        return sum;
+    }
+
+    /**
+     * Seed every model from one greedy k-means++ run for the largest k.
+     */
+    virtual void reseedModels() {
+        int largest = 0;
+        for (const Model& model: models) {
+            largest = std::max(largest, model.k);
+        }
+        auto squared = [this](int i, int j) {
+            return static_cast<double>(squaredL2(elements + static_cast<size_t>(i) * d,
+                                                 elements + static_cast<size_t>(j) * d));
+        };
+        auto random = Seeding::makeRandom(seed);
+        long evaluations = 0;
+        const std::vector<int> seeds = Seeding::greedyPlusPlus(largest, nullptr, n, squared, random, evaluations);
+        for (Model& model: models) {
+            for (int j = 0; j < model.k; j++) {
+                std::copy_n(elements + static_cast<size_t>(seeds[j]) * d, d, model.centroids.begin() + j * d);
+            }
+        }
+    }
+
+    /**
+     * Lay out the centroids of the active models side by side in the soa buffer and clear
+     * the per-column statistics.
+     */
+    virtual void packCentroids() {
+        firstColumn.resize(active.size());
+        int columns = 0;
+        for (int a = 0; a < static_cast<int>(active.size()); a++) {
+            firstColumn[a] = columns;
+            columns += models[active[a]].k;
+        }
+        stride = (columns + LANES - 1) / LANES * LANES;
+        soa.assign(static_cast<size_t>(d) * stride, 0);
+        for (int a = 0; a < static_cast<int>(active.size()); a++) {
+            const Model& model = models[active[a]];
+            for (int j = 0; j < model.k; j++) {
+                for (int dim = 0; dim < d; dim++) {
+                    soa[static_cast<size_t>(dim) * stride + firstColumn[a] + j] = model.centroids[j * d + dim];
+                }
+            }
+        }
+        counts.assign(columns, 0);
+        sums.assign(static_cast<size_t>(columns) * d, 0);
+        cost.assign(active.size(), 0.0);
+    }
+
+    /**
+     * Assign every element to its closest centroid in each active model and accumulate the
+     * per-column counts and sums. Distances to all columns are computed tile by tile from soa.
+     */
+    virtual void assignElements() {
+        std::vector<std::int32_t> dist(static_cast<size_t>(ROW_TILE) * stride);
+        for (int r0 = 0; r0 < n; r0 += ROW_TILE) {
+            const int rows = std::min(ROW_TILE, n - r0);
+            for (int c0 = 0; c0 < stride; c0 += COL_TILE) {
+                const int width = std::min(COL_TILE, stride - c0);
+                for (int r = 0; r < rows; r++) {
+                    const u_char *x = elements + static_cast<size_t>(r0 + r) * d;
+                    std::int32_t *out = dist.data() + static_cast<size_t>(r) * stride + c0;
+                    for (int j0 = 0; j0 < width; j0 += LANES) {
+                        // a local accumulator cannot alias soa, so this loop vectorizes
+                        std::int32_t acc[LANES] = {};
+                        const std::int32_t *column = soa.data() + c0 + j0;
+                        for (int dim = 0; dim < d; dim++, column += stride) {
+                            const std::int32_t xv = x[dim];
+                            for (int l = 0; l < LANES; l++) {
+                                const std::int32_t diff = xv - column[l];
+                                acc[l] += diff * diff;
+                            }
+                        }
+                        std::copy_n(acc, LANES, out + j0);
+                    }
+                }
+            }
+
+            for (int r = 0; r < rows; r++) {
+                const int i = r0 + r;
+                const u_char *x = elements + static_cast<size_t>(i) * d;
+                const std::int32_t *row = dist.data() + static_cast<size_t>(r) * stride;
+                for (int a = 0; a < static_cast<int>(active.size()); a++) {
+                    Model& model = models[active[a]];
+                    const int base = firstColumn[a];
+                    int min = 0;
+                    for (int j = 1; j < model.k; j++) {
+                        if (row[base + j] < row[base + min]) {
+                            min = j;
+                        }
+                    }
+                    model.labels[i] = min;
+                    cost[a] += row[base + min];
+                    counts[base + min]++;
+                    std::int64_t *sum = sums.data() + static_cast<size_t>(base + min) * d;
+                    for (int dim = 0; dim < d; dim++) {
+                        sum[dim] += x[dim];
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Set each non-empty cluster's centroid of models[active[a]] to the mean of its elements.
+     * Empty clusters keep their previous centroid.
+     * @param a position in active
+     * @return true if any centroid changed
+     */
+    virtual bool updateCentroids(int a) {
+        Model& model = models[active[a]];
+        const int base = firstColumn[a];
+        bool changed = false;
+        for (int j = 0; j < model.k; j++) {
+            const int count = counts[base + j];
+            model.sizes[j] = count;
+            if (count == 0) {
+                continue;
+            }
+            const std::int64_t *sum = sums.data() + static_cast<size_t>(base + j) * d;
+            for (int dim = 0; dim < d; dim++) {
+                const u_char mean = static_cast<u_char>(sum[dim] / count);
+                if (mean != model.centroids[j * d + dim]) {
+                    model.centroids[j * d + dim] = mean;
+                    changed = true;
+                }
+            }
+        }
+        return changed;
+    }
+};
@@ -11,7 +11,18 @@
 #include <iostream>
 #include <set>
 #include <array>
+#include <limits>
+#include <memory>
 #include <mpi.h>
+#include <optional>
+#include <cstdint>
+#include <utility>
+#include "HamerlyBounds.h"
+#include "Membership.h"
+#include "RunningSums.h"
+#include "MiniBatch.h"
+#include "Seeding.h"
+#include "ThreadPool.h"
 
 /**
  * MPI-parallel implementation of the naive k-means clustering algorithm.
@@ -27,6 +38,11 @@
  * Execution model:
  *  - ROOT (rank 0) calls fit(data, n) and participates in fitWork.
  *  - Non-root ranks call fitWork(rank) to help compute centroids.
+ *  - Alternatively, when each rank loads its own share of the data (e.g. with MPI-IO), every
+ *    rank calls fitPartition(local, m, rank) and nothing is scattered from ROOT.
+ *  - Optionally (setThreads), each rank runs its assignment and statistics loops on a pool
+ *    of threads sharing its partition, so one rank per node or NUMA domain can stand in for
+ *    one rank per core. Only the calling thread makes MPI calls (MPI_THREAD_FUNNELED).
  *  - Final membership (clusters[*].elements) is built once after convergence.
  *
  * Note:
@@ -42,8 +58,11 @@ public:
     class Cluster;
     typedef std::array<Cluster,k> Clusters;
     const int MAX_FIT_STEPS = 300;
+    const int SEED_ROUNDS = 5;  // k-means|| oversampling rounds in reseedClusters()
+    static constexpr int PIPELINE_BLOCKS = 4;  // blocks per partition in the pipelined mode
+    const double REBALANCE_TOLERANCE = 0.1;     // rebalance only if the slowest rank is this much over the mean
 
-    const bool VERBOSE = true;  // set to true for debugging output
+    const bool VERBOSE = false;  // set to true for debugging output
 #define V(stuff) if(VERBOSE) {using namespace std; stuff}
 
     /**
@@ -54,6 +73,124 @@ public:
         return clusters;
     }
 
+    /**
+     * Expose the final assignments of all n elements to the client readonly (ROOT only).
+     * @return labels[i] is the cluster of element i, from latest call to fit()
+     */
+    const std::vector<std::uint32_t>& getLabels() const {
+        return globalLabels;
+    }
+
+    /**
+     * Expose the final membership, grouped by cluster, to the client readonly (ROOT only).
+     * @return members of each cluster in one index array, from latest call to fit()
+     */
+    const Membership& getMembership() const {
+        return membership;
+    }
+
+    /**
+     * Turn the pruned assignment mode on or off for later fits.
+     * When on, triangle-inequality bounds (see HamerlyBounds.h) skip the distance evaluations
+     * that cannot change an element's cluster; the clustering is the same either way.
+     * Every rank must make the same choice before fit()/fitWork().
+     * @param on true to prune
+     */
+    void setPruning(bool on) {
+        pruning = on;
+    }
+
+    /**
+     * Turn the incremental cluster statistics on or off for later fits.
+     * When on, each rank keeps its per-cluster sums across generations and only moves the
+     * local elements whose label changed (see RunningSums.h), instead of summing its whole
+     * partition every generation. The clustering is the same either way.
+     * Every rank must make the same choice before fit()/fitWork().
+     * @param on true to update incrementally
+     */
+    void setIncremental(bool on) {
+        incremental = on;
+    }
+
+    /**
+     * Use a pool of threads inside this rank for later fits: assignment (updateDistances) and
+     * per-cluster statistics (updateClusters) are split over the threads, which share the
+     * rank's partition. Only the calling thread makes MPI calls, so MPI needs to be
+     * initialized with at least MPI_THREAD_FUNNELED. Ranks may use different thread counts.
+     * @param nThreads threads per rank, including the caller; 1 (the default) runs inline
+     */
+    void setThreads(int nThreads) {
+        pool = nThreads > 1 ? std::make_unique<ThreadPool>(nThreads) : nullptr;
+    }
+
+    /**
+     * Turn the pipelined generation loop on or off for later fits.
+     * When on, each rank assigns its partition in PIPELINE_BLOCKS blocks and starts a
+     * non-blocking MPI_Iallreduce of each block's statistics as soon as the block is done,
+     * polling the outstanding reductions (MPI_Testall) between blocks (see fitPipelined()).
+     * How much of a reduction actually overlaps with assignment depends on the MPI library:
+     * without a progress thread it only advances during those polls. In exchange, every
+     * generation sends PIPELINE_BLOCKS buffers of k + k*d values instead of one, so the
+     * mode only pays off when reduction latency, not bandwidth, dominates; on a single
+     * node the blocking loop with setIncremental() is about as fast.
+     * The clustering is the same either way.
+     * Every rank must make the same choice before fit()/fitWork().
+     * @param on true to pipeline
+     */
+    void setPipelined(bool on) {
+        pipelined = on;
+    }
+
+    /**
+     * Turn dynamic load balancing on or off for later fits.
+     * When on, every rank times its local work (assignment and statistics) each generation,
+     * and after every `every` generations the ranks compare their times. If the slowest rank
+     * is more than REBALANCE_TOLERANCE over the mean, the partitions are resized in
+     * proportion to each rank's measured speed and elements migrate between neighbouring
+     * ranks (see rebalance()). The clustering is the same either way.
+     * Only the standard generation loop rebalances, not the pipelined or mini-batch modes.
+     * Every rank must make the same choice before fit()/fitWork().
+     * @param every generations between rebalancing checks; 0 turns it off (the default)
+     */
+    void setRebalance(int every) {
+        rebalanceEvery = every;
+    }
+
+    /**
+     * Switch later fits between full passes and mini-batch steps.
+     * In mini-batch mode each step has every rank assign a random sample of its partition
+     * (its share of the batch); one MPI_Allreduce combines the batch statistics and every
+     * rank applies MiniBatch::step to its own copy of the centers, moving only the centroids
+     * the batch touched; a single full assignment pass then sets the final membership.
+     * Every rank must make the same choice before fit()/fitWork().
+     * @param size elements sampled per step over all ranks; 0 turns mini-batch mode off (the default)
+     * @param steps number of mini-batch steps
+     */
+    void setMiniBatch(int size, int steps) {
+        batchSize = size;
+        batchSteps = steps;
+    }
+
+    /**
+     * Fix the random seed of later fits (seeding and mini-batch sampling), so that a run
+     * can be reproduced and the modes compared; by default every fit draws a new seed from
+     * std::random_device.
+     * Each rank draws from its own stream of the seed. Every rank must pass the same seed.
+     * @param value seed
+     */
+    void setSeed(unsigned value) {
+        seed = value;
+    }
+
+    /**
+     * Number of element-to-centroid distances evaluated by the latest fit, over all ranks.
+     * Only meaningful on ROOT.
+     * @return distance evaluations (n * k per generation without pruning)
+     */
+    long getDistanceCalls() const {
+        return distanceCalls;
+    }
+
     /**
      * Run k-means clustering on the provided data.
      *
@@ -74,7 +211,7 @@ public:
      *
      * This method:
      *  1) scatters the global input into a per-rank partition,
-     *  2) iterates until convergence (or MAX_FIT_STEPS),
+     *  2) iterates until convergence (or MAX_FIT_STEPS), or runs the mini-batch steps,
      *  3) builds final membership on ROOT only,
      *  4) frees per-rank temporary storage.
      *
@@ -82,31 +219,30 @@ public:
      */
     virtual void fitWork(int rank) {
         scatterElements(rank);
+        ownsPartition = true;
+        partitionLoaded();
+        fitLoaded(rank);
+    }
 
-        // Allocate local distance table: m rows by k distances each.
-        dist.resize(m);
-
-        // Initialize centroids on ROOT, then broadcast to all ranks.
-        reseedClusters(rank);
-        Clusters prior = clusters;
-        prior[0].centroid[0]++;
-
-        int generations = 0;
-
-        while (generations++ < MAX_FIT_STEPS && prior != clusters) {
-            V(cout << rank << " working on generation " << generations << endl;)
-            updateDistances();
-            prior = clusters;
-            updateClusters();
-            mergeClusters(rank);
-            bcastCentroids(rank);
-        }
-
-        // Build final membership lists once after convergence.
-        buildMembership(rank);
-
-        delete[] partition;
-        partition = nullptr;
+    /**
+     * Run k-means clustering on data that is already spread over the ranks.
+     *
+     * Every rank (including ROOT) calls this instead of fit()/fitWork(), passing the elements
+     * it loaded itself; rank r's elements follow rank r-1's in the global numbering used by
+     * the final membership. Nothing is scattered, so ROOT never holds the whole data set.
+     *
+     * @param local this rank's elements (owned by caller; must stay valid for the duration of the call)
+     * @param local_n number of elements in local
+     * @param rank this process's MPI rank in MPI_COMM_WORLD
+     */
+    virtual void fitPartition(Element *local, int local_n, int rank) {
+        elements = nullptr;
+        partition = local;
+        m = local_n;
+        ownsPartition = false;
+        gatherLayout(rank);
+        partitionLoaded();
+        fitLoaded(rank);
     }
 
     /**
@@ -125,15 +261,78 @@ public:
     };
 
 protected:
+    /**
+     * Shared body of fitWork() and fitPartition(), run once every rank holds its partition:
+     *  1) iterates until convergence (or MAX_FIT_STEPS), or runs the mini-batch steps,
+     *  2) builds final membership on ROOT only,
+     *  3) frees per-rank temporary storage.
+     *
+     * @param rank this process's MPI rank in MPI_COMM_WORLD
+     */
+    void fitLoaded(int rank) {
+        // Allocate local assignments: one label and one distance per local element.
+        labels.resize(m);
+        nearest.resize(m);
+        distanceCalls = 0;
+        bounds.reset(m);
+        running.reset();
+
+        // Choose initial centroids together (k-means||); every rank ends with the same ones.
+        reseedClusters(rank);
+        Clusters prior = clusters;
+        prior[0].centroid[0]++;
+
+        int generations = 0;
+        workTime = 0.0;
+
+        if (batchSize > 0) {
+            fitMiniBatch(rank);
+        } else if (pipelined) {
+            fitPipelined();
+        } else {
+            while (generations++ < MAX_FIT_STEPS && prior != clusters) {
+                V(cout << rank << " working on generation " << generations << endl;)
+                const double start = MPI_Wtime();
+                updateDistances();
+                prior = clusters;
+                updateClusters();
+                workTime += MPI_Wtime() - start;
+                mergeClusters(rank);
+                if (pruning) {
+                    bounds.centroidsMoved(prior, clusters, metric());
+                }
+                if (rebalanceEvery > 0 && generations % rebalanceEvery == 0) {
+                    rebalance(rank);
+                }
+            }
+        }
+
+        // Build final membership lists once after convergence.
+        buildMembership(rank);
+
+        // Total the distance evaluations on ROOT for reporting.
+        long localCalls = distanceCalls;
+        MPI_Reduce(&localCalls, &distanceCalls, 1, MPI_LONG, MPI_SUM, ROOT, MPI_COMM_WORLD);
+
+        if (ownsPartition) {
+            delete[] partition;
+        }
+        partition = nullptr;
+    }
+
     /** Root process rank (always 0 in MPI_COMM_WORLD). */
     const int ROOT = 0;
 
     /**
      * Local partition of the input data owned by this MPI rank.
-     * Allocated in scatterElements() as an array of m Elements and freed at the end of fitWork().
+     * Allocated in scatterElements() as an array of m Elements and freed at the end of fitWork(),
+     * or the caller's array passed to fitPartition().
      */
     Element *partition = nullptr;
 
+    /** Whether partition was allocated here (scatterElements()) and must be freed. */
+    bool ownsPartition = true;
+
     /** Number of Elements in this rank's local partition. */
     int m = 0;
 
@@ -141,19 +340,18 @@ protected:
     int p = 1;
 
     /**
-     * Per-rank cluster counts computed during updateClusters().
-     * localCounts[j] = number of local elements assigned to cluster j.
+     * Per-rank cluster statistics computed during updateClusters(), packed so that one
+     * MPI_Allreduce combines them (see STATS).
+     * localStats[j] = number of local elements assigned to cluster j.
+     * localStats[k + j*d + dim] = sum of coordinate 'dim' over local elements assigned to cluster j.
      */
-    int *localCounts = nullptr;
+    std::int64_t *localStats = nullptr;
 
-    /**
-     * Per-rank cluster sums computed during updateClusters().
-     * localSums[j*d + dim] = sum of coordinate 'dim' over local elements assigned to cluster j.
-     */
-    double *localSums = nullptr;
+    /** Length of localStats: k counts followed by k*d sums. */
+    static constexpr int STATS = k + k * d;
 
     /**
-     * ROOT-only scatter layout (in Elements).
+     * ROOT-only scatter layout (in Elements), set by scatterElements() or gatherLayout().
      * sendcounts_element[r] = number of Elements sent to rank r.
      */
     int *sendcounts_element = nullptr;
@@ -174,17 +372,70 @@ protected:
     Clusters clusters;
 
     /**
-     * Local distance table.
-     * dist[i][j] is the distance from this rank's partition[i] to clusters[j].centroid.
-     * Size is m rows by k columns.
+     * Local assignments.
+     * labels[i] is the index of the centroid closest to this rank's partition[i].
+     * Size is m.
      */
-    std::vector<std::array<double,k>> dist;
+    std::vector<std::uint32_t> labels;
+
+    /** ROOT-only final assignments of all n elements, gathered in buildMembership(). */
+    std::vector<std::uint32_t> globalLabels;
+
+    /** ROOT-only final membership grouped by cluster, built from globalLabels. */
+    Membership membership;
+
+    /**
+     * Local distances to the assigned centroids.
+     * nearest[i] is the distance from partition[i] to clusters[labels[i]].centroid.
+     * Size is m.
+     */
+    std::vector<double> nearest;
+
+    /** Whether updateDistances() uses `bounds` (see setPruning()). */
+    bool pruning = false;
+
+    /** Per-element distance bounds for the pruned mode, covering this rank's partition. */
+    HamerlyBounds<k,d> bounds;
+
+    /** Distance evaluations on this rank so far in the latest fit (after fitWork, the total on ROOT). */
+    long distanceCalls = 0;
+
+    /** Whether updateClusters() uses `running` (see setIncremental()). */
+    bool incremental = false;
+
+    /** Per-cluster sums over this rank's partition, kept across generations for the incremental mode. */
+    RunningSums<k,d> running;
+
+    /** Threads sharing this rank's loops, or null to run them inline (see setThreads()). */
+    std::unique_ptr<ThreadPool> pool;
+
+    /** threadStats[t] is pool thread t's share of localStats during updateClusters(). */
+    std::vector<std::vector<std::int64_t>> threadStats;
+
+    /** Whether fitWork() uses fitPipelined() (see setPipelined()). */
+    bool pipelined = false;
+
+    /** Fixed random seed, if any (see setSeed()). */
+    std::optional<unsigned> seed;
+
+    /** Elements per mini-batch step over all ranks; 0 for full passes (see setMiniBatch()). */
+    int batchSize = 0;
+
+    /** Number of mini-batch steps. */
+    int batchSteps = 0;
+
+    /** Generations between rebalancing checks; 0 for a fixed partition (see setRebalance()). */
+    int rebalanceEvery = 0;
+
+    /** Seconds this rank spent on local work since the latest rebalancing check. */
+    double workTime = 0.0;
 
     /**
      * Scatter the global input array (elements[0..n)) from ROOT to all ranks.
      *
      * Each rank receives m Elements into `partition`, where m is determined by an even split
-     * and any remainder assigned to the last rank.
+     * and the remainder is spread one element each over the first n % p ranks, so no rank
+     * has more than one element over any other.
      *
      * ROOT also stores sendcounts_element/displs_element (in units of Elements) for later use
      * by buildMembership().
@@ -210,12 +461,8 @@ protected:
             int reminder = n % p;
 
             for (int pi = 0; pi < p; pi++) {
-                sendcounts_element[pi] = element_per_proc;
-                displs_element[pi] = element_per_proc * pi;
-
-                if (pi == p - 1) {
-                    sendcounts_element[pi] += reminder;
-                }
+                sendcounts_element[pi] = element_per_proc + (pi < reminder ? 1 : 0);
+                displs_element[pi] = element_per_proc * pi + std::min(pi, reminder);
             }
 
             V(
@@ -288,23 +535,266 @@ protected:
 
 
     /**
-     * Get the initial cluster centroids.
-     * Pick k elements at random from the element set
-     * @return list of clusters made by using k random elements as the initial centroids
+     * Learn the global layout when every rank already holds its partition (fitPartition()).
+     *
+     * Every rank learns n and p from the ranks' partition sizes (MPI_Allgather); ROOT also
+     * stores sendcounts_element/displs_element, in rank order, for buildMembership().
+     *
+     * @param rank this process's MPI rank
+     */
+    void gatherLayout(int rank) {
+        MPI_Comm_size(MPI_COMM_WORLD, &p);
+        std::vector<int> sizes(p);
+        MPI_Allgather(&m, 1, MPI_INT, sizes.data(), 1, MPI_INT, MPI_COMM_WORLD);
+
+        n = 0;
+        if (rank == ROOT) {
+            sendcounts_element = new int[p];
+            displs_element = new int[p];
+        }
+        for (int pi = 0; pi < p; pi++) {
+            if (rank == ROOT) {
+                sendcounts_element[pi] = sizes[pi];
+                displs_element[pi] = n;
+            }
+            n += sizes[pi];
+        }
+        V(cout << rank << " holds " << m << " of " << n << " elements" << endl;)
+    }
+
+    /**
+     * Resize the partitions to the ranks' measured speeds, if they are out of balance.
+     *
+     * Every rank shares its partition size and workTime (MPI_Allgather) and so computes the
+     * same new layout: rank r's share of the n elements is proportional to its speed
+     * m_r / workTime_r. A rank with no measurement (an empty partition) is given the mean
+     * speed. Partitions stay contiguous and in rank order, so the global numbering used by
+     * buildMembership() is unchanged and each rank only exchanges the overlap between its
+     * old and new ranges (MPI_Alltoallv of the elements and their labels).
+     *
+     * Afterwards the per-element state built on the old partition (Hamerly bounds, running
+     * sums) is reset and partitionLoaded() is called again.
+     *
+     * @param rank this process's MPI rank
+     */
+    void rebalance(int rank) {
+        std::vector<int> sizes(p);
+        std::vector<double> times(p);
+        MPI_Allgather(&m, 1, MPI_INT, sizes.data(), 1, MPI_INT, MPI_COMM_WORLD);
+        MPI_Allgather(&workTime, 1, MPI_DOUBLE, times.data(), 1, MPI_DOUBLE, MPI_COMM_WORLD);
+        workTime = 0.0;
+
+        // only act on an imbalance worth the migration
+        double slowest = 0.0, mean = 0.0;
+        for (int pi = 0; pi < p; pi++) {
+            slowest = std::max(slowest, times[pi]);
+            mean += times[pi] / p;
+        }
+        if (slowest <= (1.0 + REBALANCE_TOLERANCE) * mean) {
+            return;
+        }
+
+        // speed (elements per second) of each rank, and the new sizes in proportion to it
+        std::vector<double> speeds(p, 0.0);
+        double total = 0.0;
+        int measured = 0;
+        for (int pi = 0; pi < p; pi++) {
+            if (sizes[pi] > 0 && times[pi] > 0.0) {
+                speeds[pi] = sizes[pi] / times[pi];
+                total += speeds[pi];
+                measured++;
+            }
+        }
+        if (measured == 0) {
+            return;
+        }
+        for (int pi = 0; pi < p; pi++) {
+            if (speeds[pi] == 0.0) {
+                speeds[pi] = total / measured;
+            }
+        }
+        total = 0.0;
+        for (double speed: speeds) {
+            total += speed;
+        }
+        std::vector<int> targets(p);
+        int assigned = 0;
+        for (int pi = 0; pi < p; pi++) {
+            targets[pi] = static_cast<int>(n * (speeds[pi] / total));
+            assigned += targets[pi];
+        }
+        for (int pi = 0; assigned < n; pi = (pi + 1) % p, assigned++) {
+            targets[pi]++;
+        }
+
+        // old and new ranges are both contiguous in rank order; send each rank the overlap
+        std::vector<int> oldStart(p + 1, 0), newStart(p + 1, 0);
+        for (int pi = 0; pi < p; pi++) {
+            oldStart[pi + 1] = oldStart[pi] + sizes[pi];
+            newStart[pi + 1] = newStart[pi] + targets[pi];
+        }
+        auto overlap = [](int lo1, int hi1, int lo2, int hi2) {
+            return std::max(0, std::min(hi1, hi2) - std::max(lo1, lo2));
+        };
+        std::vector<int> sendCounts(p), sendDispls(p), recvCounts(p), recvDispls(p);
+        for (int pi = 0; pi < p; pi++) {
+            sendCounts[pi] = overlap(oldStart[rank], oldStart[rank + 1], newStart[pi], newStart[pi + 1]);
+            sendDispls[pi] = std::max(oldStart[rank], newStart[pi]) - oldStart[rank];
+            recvCounts[pi] = overlap(newStart[rank], newStart[rank + 1], oldStart[pi], oldStart[pi + 1]);
+            recvDispls[pi] = std::max(newStart[rank], oldStart[pi]) - newStart[rank];
+            if (sendCounts[pi] == 0) {
+                sendDispls[pi] = 0;
+            }
+            if (recvCounts[pi] == 0) {
+                recvDispls[pi] = 0;
+            }
+        }
+
+        // migrate whole elements (counted in Elements, not bytes) and their labels
+        const int newM = targets[rank];
+        Element *moved = new Element[newM];
+        std::vector<std::uint32_t> movedLabels(newM);
+        MPI_Datatype elementType;
+        MPI_Type_contiguous(d, MPI_UNSIGNED_CHAR, &elementType);
+        MPI_Type_commit(&elementType);
+        MPI_Alltoallv(partition, sendCounts.data(), sendDispls.data(), elementType,
+            moved, recvCounts.data(), recvDispls.data(), elementType, MPI_COMM_WORLD);
+        MPI_Alltoallv(labels.data(), sendCounts.data(), sendDispls.data(), MPI_UINT32_T,
+            movedLabels.data(), recvCounts.data(), recvDispls.data(), MPI_UINT32_T, MPI_COMM_WORLD);
+        MPI_Type_free(&elementType);
+        V(cout << rank << " rebalanced from " << m << " to " << newM << " elements" << endl;)
+
+        if (ownsPartition) {
+            delete[] partition;
+        }
+        partition = moved;
+        ownsPartition = true;
+        m = newM;
+        labels = std::move(movedLabels);
+        nearest.assign(m, 0.0);
+        bounds.reset(m);
+        running.reset();
+        if (rank == ROOT) {
+            std::copy(targets.begin(), targets.end(), sendcounts_element);
+            std::copy(newStart.begin(), newStart.end() - 1, displs_element);
+        }
+        partitionLoaded();
+    }
+
+    /**
+     * Called on every rank once its partition is in place, before seeding, and again after
+     * rebalance() moves elements. Subclasses that precompute per-element data (such as
+     * norms) hook in here.
+     */
+    virtual void partitionLoaded() {}
+
+    /**
+     * Get the initial cluster centroids by k-means|| (Bahmani et al., "Scalable K-Means++"),
+     * a parallel form of k-means++ (see Seeding.h):
+     *  1) one element, drawn uniformly over all n, is the first candidate;
+     *  2) for SEED_ROUNDS rounds, each rank keeps every local element with probability
+     *     min(1, 2k * cost / phi), where cost is the element's squared distance to its nearest
+     *     candidate and phi the total cost over all ranks (MPI_Allreduce), and the kept
+     *     elements of all ranks are appended to every rank's candidates (MPI_Allgatherv);
+     *  3) each candidate is weighted by the number of elements nearest to it (MPI_Reduce);
+     *  4) ROOT picks k centroids from the weighted candidates by k-means++ and broadcasts them.
+     * Each rank reads only its own partition, so ROOT need not hold the whole data set.
+     *
+     * @param rank this process's MPI rank
      */
     virtual void reseedClusters(int rank) {
         V(cout << rank << " is at reseedClusters" << endl;)
+        auto random = Seeding::makeRandom(seed, rank);
+        int *counts = new int[p];
+        MPI_Allgather(&m, 1, MPI_INT, counts, 1, MPI_INT, MPI_COMM_WORLD);
+
+        // 1) first candidate: ROOT draws a global index and the rank holding it broadcasts it
+        int first = 0;
         if (rank == ROOT) {
-            V(cout << rank << " is reseeding clusters: " << endl;)
-            std::vector<int> seeds;
-            std::vector<int> candidates(n);
-            std::iota(candidates.begin(), candidates.end(), 0);
-            auto random = std::mt19937{std::random_device{}()};
-            // Note that we need C++20 for std::sample
-            std::sample(candidates.begin(), candidates.end(), back_inserter(seeds), k, random);
+            first = std::uniform_int_distribution<int>(0, n - 1)(random);
+        }
+        MPI_Bcast(&first, 1, MPI_INT, ROOT, MPI_COMM_WORLD);
+        int holder = 0;
+        while (first >= counts[holder]) {
+            first -= counts[holder++];
+        }
+        std::vector<Element> candidates(1);
+        if (rank == holder) {
+            candidates[0] = partition[first];
+        }
+        MPI_Bcast(candidates[0].data(), d, MPI_UNSIGNED_CHAR, holder, MPI_COMM_WORLD);
+
+        // 2) oversampling rounds; cost[i] and closest[i] track local element i's nearest candidate
+        std::vector<double> cost(m, std::numeric_limits<double>::infinity());
+        std::vector<int> closest(m, 0);
+        int *displs = new int[p];
+        int scored = 0;  // candidates already folded into cost
+        for (int round = 0; ; round++) {
+            const int total = static_cast<int>(candidates.size());
+            double localCost = 0.0;
+            for (int i = 0; i < m; i++) {
+                for (int c = scored; c < total; c++) {
+                    const double dist = distance(candidates[c], partition[i]);
+                    if (dist * dist < cost[i]) {
+                        cost[i] = dist * dist;
+                        closest[i] = c;
+                    }
+                }
+                localCost += cost[i];
+            }
+            distanceCalls += static_cast<long>(m) * (total - scored);
+            scored = total;
+            if (round == SEED_ROUNDS) {
+                break;
+            }
+
+            double phi;
+            MPI_Allreduce(&localCost, &phi, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+            if (phi == 0.0) {
+                break;  // every element already sits on a candidate
+            }
+            std::vector<Element> kept;
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            for (int i = 0; i < m; i++) {
+                if (uniform(random) * phi < 2.0 * k * cost[i]) {
+                    kept.push_back(partition[i]);
+                }
+            }
 
+            // append every rank's kept elements, in rank order, to the candidates
+            const int keptBytes = static_cast<int>(kept.size()) * d;
+            MPI_Allgather(&keptBytes, 1, MPI_INT, counts, 1, MPI_INT, MPI_COMM_WORLD);
+            int added = 0;
+            for (int r = 0; r < p; r++) {
+                displs[r] = added;
+                added += counts[r];
+            }
+            candidates.resize(total + added / d);
+            MPI_Allgatherv(kept.data(), keptBytes, MPI_UNSIGNED_CHAR,
+                reinterpret_cast<u_char*>(candidates.data() + total), counts, displs, MPI_UNSIGNED_CHAR,
+                MPI_COMM_WORLD);
+        }
+        delete[] counts;
+        delete[] displs;
+
+        // 3) weight each candidate by the elements it attracts
+        const int total = static_cast<int>(candidates.size());
+        std::vector<double> localWeights(total, 0.0), weights;
+        for (int i = 0; i < m; i++) {
+            localWeights[closest[i]] += 1.0;
+        }
+        if (rank == ROOT) {
+            weights.resize(total);
+        }
+        MPI_Reduce(localWeights.data(), weights.data(), total, MPI_DOUBLE, MPI_SUM, ROOT, MPI_COMM_WORLD);
+
+        // 4) weighted k-means++ over the candidates on ROOT
+        if (rank == ROOT) {
+            V(cout << rank << " is reseeding clusters from " << total << " candidates" << endl;)
+            std::vector<int> seeds = Seeding::kMeansPlusPlus<k,d>(candidates.data(), weights.data(), total,
+                                                                  metric(), random, distanceCalls);
             for (int i = 0; i < k; i++) {
-                clusters[i].centroid = elements[seeds[i]];
+                clusters[i].centroid = candidates[seeds[i]];
                 clusters[i].elements.clear();
                 V(
                     cout << "cluster: " << i << " centroid is: " << endl;
@@ -321,50 +811,128 @@ protected:
     }
 
     /**
-     * Compute the distance from each local element in `partition` to each cluster centroid.
-     * Results are stored in `dist` (m x k).
+     * Find the closest cluster centroid to each local element in `partition` (see
+     * closestCluster): its index goes into `labels` and its distance into `nearest`.
+     * Memory is O(m) rather than an m x k table.
      */
     virtual void updateDistances() {
-        for (int i = 0; i < m; i++) {
+        prepareAssignment();
+        distanceCalls += assignThreaded(0, m);
+    }
+
+    /**
+     * Assign local elements [lo, hi) with assignRange(), split over the pool threads if any.
+     * @param lo first local element
+     * @param hi one past the last local element
+     * @return number of distance evaluations made
+     */
+    long assignThreaded(int lo, int hi) {
+        if (!pool) {
+            return assignRange(lo, hi);
+        }
+        std::vector<long> evaluations(pool->size());
+        pool->run([this, lo, hi, &evaluations](int t) {
+            int from, to;
+            pool->slice(t, hi - lo, from, to);
+            evaluations[t] = assignRange(lo + from, lo + to);
+        });
+        long total = 0;
+        for (long e: evaluations) {
+            total += e;
+        }
+        return total;
+    }
+
+    /**
+     * Per-generation setup before assignRange() is called on any range with the current
+     * centroids. Does nothing here; a subclass with its own distance engine can load the
+     * centroids into it.
+     */
+    virtual void prepareAssignment() {}
+
+    /**
+     * Assign local elements [lo, hi) to their closest centroids, setting `labels` and `nearest`.
+     * In the pruned mode, only the distances the bounds cannot rule out are evaluated.
+     * Pool threads call this at once on disjoint ranges, so it must not write shared state
+     * outside those ranges.
+     * @param lo first local element
+     * @param hi one past the last local element
+     * @return number of distance evaluations made
+     */
+    virtual long assignRange(int lo, int hi) {
+        if (pruning) {
+            return bounds.assign(partition, lo, hi, clusters, metric(), labels.data(), nearest.data());
+        }
+        for (int i = lo; i < hi; i++) {
             V(cout<<"distances for "<<i<<"(";for(int x=0;x<d;x++)printf("%02x",partition[i][x]);)
-            for (int j = 0; j < k; j++) {
-                dist[i][j] = distance(clusters[j].centroid, partition[i]);
-                V(cout<<" " << dist[i][j];)
-            }
-            V(cout<<endl;)
+            labels[i] = closestCluster(partition[i], nearest[i]);
+            V(cout<<" closest "<<labels[i]<<" at "<<nearest[i]<<endl;)
         }
+        return static_cast<long>(hi - lo) * k;
     }
 
     /**
-     * Assign each local element to its nearest centroid and accumulate per-cluster statistics.
+     * Accumulate per-cluster statistics for the local elements assigned in `labels`.
+     *
+     * Produces localStats:
+     *  - localStats[j] = number of local elements assigned to cluster j
+     *  - localStats[k + j*d + dim] = sum of byte dimension 'dim' for cluster j over local elements
      *
-     * Produces:
-     *  - localCounts[j] = number of local elements assigned to cluster j
-     *  - localSums[j*d + dim] = sum of byte dimension 'dim' for cluster j over local elements
+     * In the incremental mode these are copied from `running`, which only visits the local
+     * elements whose label changed. Otherwise, with a pool, each thread sums its own slice
+     * into threadStats and the slices are then added together.
      */
     virtual void updateClusters() {
         // reinitialize local data
-        localCounts = new int[k]();
-        localSums = new double[k * d]();
+        localStats = new std::int64_t[STATS]();
 
-        // iterate through all the elements assigned to me
-        for (int i = 0; i < m; i++) {
-            int min = 0;
+        if (incremental) {
+            running.update(partition, labels.data(), m);
+            for (int j = 0; j < k; j++) {
+                localStats[j] = running.count(j);
+                std::copy_n(running.sum(j), d, localStats + k + j * d);
+            }
+            return;
+        }
 
-            // iterate through dist and find the closest cluster min
-            for (int j = 1; j < k; j++) {
-                if (dist[i][j] < dist[i][min]) {
-                    min = j;
-                }
+        if (!pool) {
+            accumulateRange(localStats, 0, m);
+            return;
+        }
+        threadStats.resize(pool->size());
+        pool->run([this](int t) {
+            int lo, hi;
+            pool->slice(t, m, lo, hi);
+            threadStats[t].assign(STATS, 0);
+            accumulateRange(threadStats[t].data(), lo, hi);
+        });
+        for (const std::vector<std::int64_t>& stats: threadStats) {
+            for (int s = 0; s < STATS; s++) {
+                localStats[s] += stats[s];
             }
+        }
+    }
+
+    /**
+     * Add the local elements [lo, hi) to a packed statistics buffer laid out as localStats.
+     * @param stats buffer of STATS values
+     * @param lo first local element
+     * @param hi one past the last local element
+     */
+    void accumulateRange(std::int64_t *stats, int lo, int hi) const {
+        std::int64_t *sums = stats + k;
+
+        // iterate through all the elements assigned to me
+        for (int i = lo; i < hi; i++) {
+            const int min = labels[i];
 
             // number of elements in min cluster++
-            localCounts[min]++;
+            stats[min]++;
 
             // accumulate sum for each dimension
             for (int dim = 0; dim < d; dim++) {
                 // cluster index min * number of dimensions = starting index of sums
-                localSums[min * d + dim] += partition[i][dim];
+                sums[min * d + dim] += partition[i][dim];
             }
         }
     }
@@ -372,100 +940,221 @@ protected:
     /**
      * Merge per-rank cluster statistics into global centroids.
      *
-     * Uses MPI_Reduce with MPI_SUM to accumulate counts/sums on ROOT, then ROOT updates
-     * each centroid as mean = globalSums / globalCounts.
+     * One MPI_Allreduce with MPI_SUM combines the packed counts and sums of all ranks, and
+     * every rank then updates each centroid as mean = sum / count itself. The sums are exact
+     * integers, so all ranks compute identical centroids and no broadcast from ROOT is needed.
+     * Empty clusters keep their previous centroid.
      *
      * @param rank this process's MPI rank
      */
     virtual void mergeClusters(int rank) {
-        int *globalCounts = nullptr;
-        double *globalSums = nullptr;
+        std::int64_t *globalStats = new std::int64_t[STATS];
 
-        if (rank == ROOT) {
-            globalCounts = new int[k]();
-            globalSums = new double[k * d]();
+        MPI_Allreduce(localStats, globalStats, STATS,
+            MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+        const std::int64_t *globalSums = globalStats + k;
+        for (int i = 0; i < k; i++) {
+            if (globalStats[i] > 0) {
+                for (int dim = 0; dim < d; dim++) {
+                    clusters[i].centroid[dim] = static_cast<u_char>(globalSums[i * d + dim] / globalStats[i]);
+                }
+            }
         }
 
-        MPI_Reduce(localCounts, globalCounts, k,
-            MPI_INT, MPI_SUM, ROOT, MPI_COMM_WORLD);
+        delete[] globalStats;
+        delete[] localStats;
+        localStats = nullptr;
+    }
+
+    /**
+     * Pipelined replacement for the generation loop of fitWork().
+     *
+     * Each generation, the partition is assigned in PIPELINE_BLOCKS blocks. For each block the
+     * rank builds a delta buffer (STATS + 1 values): the change in per-cluster counts and sums
+     * caused by the block's elements that changed cluster since the previous generation (all
+     * of them in the first), followed by how many changed. An MPI_Iallreduce of that buffer
+     * starts right away, and the rank moves on to the next block while it is in flight,
+     * calling MPI_Testall on the posted reductions after each block so that libraries without
+     * an asynchronous progress thread still push them forward. After
+     * the last block, MPI_Waitall collects the reduced deltas, every rank adds them to its copy
+     * of the global totals and recomputes the centroids, as mergeClusters() does. There is no
+     * broadcast: the exact integer totals are identical on all ranks.
+     *
+     * The convergence test rides in the same reductions: when no element on any rank changed
+     * cluster, the centroids cannot change either, so the loop stops without comparing
+     * centroids. Every rank posts the same PIPELINE_BLOCKS reductions per generation, even if
+     * its blocks are empty, so the collectives always match up.
+     */
+    virtual void fitPipelined() {
+        constexpr int BUFFER = STATS + 1;  // deltas, then the changed count
+        const int blockSize = (m + PIPELINE_BLOCKS - 1) / PIPELINE_BLOCKS;
+        std::vector<std::int64_t> totals(STATS, 0);
+        std::vector<std::int64_t> localDeltas(PIPELINE_BLOCKS * BUFFER), globalDeltas(PIPELINE_BLOCKS * BUFFER);
+        std::vector<std::uint32_t> before(blockSize);
+        MPI_Request requests[PIPELINE_BLOCKS];
+
+        std::int64_t changed = 1;
+        for (int generation = 0; generation < MAX_FIT_STEPS && changed > 0; generation++) {
+            V(cout << "working on pipelined generation " << generation << endl;)
+            const Clusters prior = clusters;
+            prepareAssignment();
+            for (int b = 0; b < PIPELINE_BLOCKS; b++) {
+                const int lo = std::min(m, b * blockSize);
+                const int hi = std::min(m, lo + blockSize);
+                std::copy(labels.begin() + lo, labels.begin() + hi, before.begin());
+                distanceCalls += assignThreaded(lo, hi);
+
+                std::int64_t *delta = localDeltas.data() + b * BUFFER;
+                std::fill(delta, delta + BUFFER, 0);
+                for (int i = lo; i < hi; i++) {
+                    if (generation > 0 && labels[i] == before[i - lo]) {
+                        continue;
+                    }
+                    if (generation > 0) {
+                        addToStats(delta, partition[i], before[i - lo], -1);
+                    }
+                    addToStats(delta, partition[i], labels[i], 1);
+                    delta[STATS]++;
+                }
+                MPI_Iallreduce(delta, globalDeltas.data() + b * BUFFER, BUFFER,
+                    MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD, &requests[b]);
 
-        MPI_Reduce(localSums, globalSums, k * d,
-            MPI_DOUBLE, MPI_SUM, ROOT, MPI_COMM_WORLD);
+                // without a progress thread, reductions only advance inside MPI calls
+                int done;
+                MPI_Testall(b + 1, requests, &done, MPI_STATUSES_IGNORE);
+            }
+            MPI_Waitall(PIPELINE_BLOCKS, requests, MPI_STATUSES_IGNORE);
 
-        if (rank == ROOT) {
-            for (int i = 0; i < k; i++) {
-                if (globalCounts[i] > 0) {
+            changed = 0;
+            for (int b = 0; b < PIPELINE_BLOCKS; b++) {
+                const std::int64_t *delta = globalDeltas.data() + b * BUFFER;
+                for (int s = 0; s < STATS; s++) {
+                    totals[s] += delta[s];
+                }
+                changed += delta[STATS];
+            }
+            const std::int64_t *sums = totals.data() + k;
+            for (int j = 0; j < k; j++) {
+                if (totals[j] > 0) {
                     for (int dim = 0; dim < d; dim++) {
-                        const double mean = globalSums[i * d + dim] / globalCounts[i];
-                        clusters[i].centroid[dim] = static_cast<u_char>(mean);
+                        clusters[j].centroid[dim] = static_cast<u_char>(sums[j * d + dim] / totals[j]);
                     }
                 }
             }
-
-            delete[] globalCounts;
-            delete[] globalSums;
+            if (pruning) {
+                bounds.centroidsMoved(prior, clusters, metric());
+            }
         }
+    }
 
-        delete[] localCounts;
-        delete[] localSums;
-        localCounts = nullptr;
-        localSums = nullptr;
+    /**
+     * Add (sign 1) or remove (sign -1) one element to a packed statistics buffer laid out as
+     * localStats (k counts, then k*d sums).
+     * @param stats buffer of at least STATS values
+     * @param e the element
+     * @param j its cluster
+     * @param sign 1 or -1
+     */
+    static void addToStats(std::int64_t *stats, const Element& e, int j, int sign) {
+        stats[j] += sign;
+        std::int64_t *sum = stats + k + j * d;
+        for (int dim = 0; dim < d; dim++) {
+            sum[dim] += sign * static_cast<int>(e[dim]);
+        }
     }
 
     /**
-     * Build final cluster membership lists after convergence.
+     * Mini-batch replacement for the generation loop of fitWork(), starting from the seeded clusters.
      *
-     * Each rank computes a local cluster ID for each of its m elements, then ROOT gathers
-     * these IDs into a global affiliation array (size n) using MPI_Gatherv and the same
-     * scatter displacements. ROOT then populates clusters[c].elements with global indices.
+     * Each step, every rank samples its share of the batch from its own partition (with
+     * replacement, in proportion to m), assigns the samples, and accumulates their per-cluster
+     * counts and sums into localStats as updateClusters() does. One MPI_Allreduce combines
+     * them, and every rank applies the same totals with MiniBatch::step to its own copy of the
+     * centers, so the centroids stay identical without a broadcast. Then every local element
+     * is assigned once (updateDistances) for the final membership; the centroids are left as
+     * the mini-batch steps put them.
      *
      * @param rank this process's MPI rank
      */
-    virtual void buildMembership(int rank) {
-        int *localAffiliation = new int[m]();
-        int *globalAffiliation = nullptr;
-
-        if (rank == ROOT) {
-            globalAffiliation = new int[n]();
+    virtual void fitMiniBatch(int rank) {
+        double *centers = new double[k * d];
+        long *seen = new long[k]();
+        for (int j = 0; j < k; j++) {
+            for (int dim = 0; dim < d; dim++) {
+                centers[j * d + dim] = clusters[j].centroid[dim];
+            }
         }
 
-        for (int i = 0; i < m; i++) {
-            int min = 0;
-            for (int j = 1; j < k; j++) {
-                if (dist[i][j] < dist[i][min]) {
-                    min = j;
+        const int share = n > 0 ? static_cast<int>((static_cast<long>(batchSize) * m + n - 1) / n) : 0;
+        auto random = Seeding::makeRandom(seed, rank);
+        std::uniform_int_distribution<int> pick(0, m > 0 ? m - 1 : 0);
+        std::int64_t *globalStats = new std::int64_t[STATS];
+
+        for (int step = 0; step < batchSteps; step++) {
+            localStats = new std::int64_t[STATS]();
+            std::int64_t *localSums = localStats + k;
+            for (int b = 0; b < share; b++) {
+                const Element& e = partition[pick(random)];
+                double dist;
+                const int min = closestCluster(e, dist);
+                localStats[min]++;
+                for (int dim = 0; dim < d; dim++) {
+                    localSums[min * d + dim] += e[dim];
                 }
             }
-            localAffiliation[i] = min;
+            distanceCalls += static_cast<long>(share) * k;
+
+            MPI_Allreduce(localStats, globalStats, STATS, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+            MiniBatch::step<k,d>(centers, seen, globalStats, globalStats + k, clusters);
+            delete[] localStats;
+            localStats = nullptr;
+        }
+
+        updateDistances();
+
+        delete[] globalStats;
+        delete[] centers;
+        delete[] seen;
+    }
+
+    /**
+     * Build final cluster membership lists after convergence.
+     *
+     * Each rank already holds a cluster ID for each of its m elements in `labels`; ROOT gathers
+     * these IDs into globalLabels (size n) using MPI_Gatherv and the same scatter
+     * displacements. ROOT then groups them with one counting sort (see Membership.h) and
+     * fills each clusters[c].elements with a single allocation.
+     *
+     * @param rank this process's MPI rank
+     */
+    virtual void buildMembership(int rank) {
+        if (rank == ROOT) {
+            globalLabels.resize(n);
         }
 
         MPI_Gatherv(
-            localAffiliation, m, MPI_INT,
-            globalAffiliation, sendcounts_element, displs_element, MPI_INT,
+            labels.data(), m, MPI_UINT32_T,
+            globalLabels.data(), sendcounts_element, displs_element, MPI_UINT32_T,
             ROOT, MPI_COMM_WORLD
             );
 
         if (rank == ROOT) {
-            for (auto &c : clusters) {
-                c.elements.clear();
-            }
-
-            for (int i = 0; i < n; i++) {
-                clusters[globalAffiliation[i]].elements.push_back(i);
+            membership.build(globalLabels.data(), n, k);
+            for (int j = 0; j < k; j++) {
+                clusters[j].elements.assign(membership.begin(j), membership.end(j));
             }
 
-            delete[] globalAffiliation;
             delete[] sendcounts_element;
             delete[] displs_element;
             sendcounts_element = nullptr;
             displs_element = nullptr;
         }
-
-        delete[] localAffiliation;
     }
 
     /**
      * Broadcast the current centroids from ROOT to all ranks.
+     * Needed only after seeding; each generation's centroids are computed on every rank.
      * Centroids are marshaled into a contiguous byte buffer of size k*d.
      *
      * @param rank this process's MPI rank
@@ -502,6 +1191,35 @@ protected:
     }
 
 
+    /**
+     * Find the centroid closest to an element.
+     * This default calls distance() once per centroid; a subclass with a faster kernel for
+     * its metric can override it to replace the k virtual distance() calls per element.
+     * @param e element to place
+     * @param dist set to the distance from e to the closest centroid
+     * @return index of the closest centroid (the lowest index on ties)
+     */
+    virtual int closestCluster(const Element& e, double& dist) const {
+        int min = 0;
+        double best = distance(clusters[0].centroid, e);
+        for (int j = 1; j < k; j++) {
+            const double dj = distance(clusters[j].centroid, e);
+            if (dj < best) {
+                best = dj;
+                min = j;
+            }
+        }
+        dist = best;
+        return min;
+    }
+
+    /**
+     * @return this->distance() as a callable, for HamerlyBounds
+     */
+    auto metric() const {
+        return [this](const Element& a, const Element& b) { return distance(a, b); };
+    }
+
     /**
      * Subclass-supplied method to calculate the distance between two elements
      * @param a one element
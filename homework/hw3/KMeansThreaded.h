@@ -0,0 +1,168 @@
+/**
+* @file KMeansThreaded.h - shared-memory multithreaded implementation of the k-means algorithm
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#pragma once  // only process the first time it is included; ignore otherwise
+#include <array>
+#include <thread>
+#include <vector>
+#include "KMeans.h"
+#include "ThreadPool.h"
+
+/**
+ * Multithreaded k-means for a single machine, with no MPI processes involved.
+ *
+ * Template parameters:
+ *  - k: number of clusters
+ *  - d: dimensionality (bytes per element)
+ *
+ * Execution model:
+ *  - The n elements are split into one contiguous slice per pool thread.
+ *  - Each generation, every thread assigns each element of its slice to the closest
+ *    centroid (see KMeans::closestCluster), and accumulates per-cluster counts and sums
+ *    into its own Accumulator (no sharing, no locks).
+ *  - The per-thread accumulators are then merged with a pairwise tree reduction
+ *    (log2(threads) rounds, each round merging pairs in parallel), and the centroids are
+ *    the merged sums divided by the merged counts, as in KMeansMPI.
+ *  - Final membership (clusters[*].elements and the Membership view) is built once after
+ *    convergence, as in KMeans.
+ *
+ * Subclasses supply distance() (and optionally closestCluster()) exactly as for KMeans.
+ */
+template <int k, int d>
+class KMeansThreaded : public KMeans<k,d> {
+public:
+    typedef typename KMeans<k,d>::Element Element;
+    typedef typename KMeans<k,d>::Clusters Clusters;
+
+    /**
+     * @param nThreads number of threads to cluster with; defaults to every hardware thread
+     */
+    explicit KMeansThreaded(int nThreads = static_cast<int>(std::thread::hardware_concurrency()))
+        : pool(nThreads), partials(pool.size()) {}
+
+    /**
+     * Run k-means clustering on the provided data using every pool thread.
+     * Mini-batch mode (see KMeans::setMiniBatch) runs on the calling thread only.
+     * The incremental mode (KMeans::setIncremental) does not apply: each thread sums its own slice.
+     * @param data pointer to n Elements (owned by caller; must stay valid for the duration of fit)
+     * @param data_n number of elements in the data array
+     */
+    void fit(const Element *data, int data_n) override {
+        if (this->batchSize > 0) {
+            KMeans<k,d>::fit(data, data_n);
+            return;
+        }
+        this->elements = data;
+        this->n = data_n;
+        this->labels.resize(this->n);
+        this->nearest.resize(this->n);
+        this->distanceCalls = 0;
+        this->bounds.reset(this->n);
+        this->reseedClusters();
+        Clusters prior = this->clusters;
+        prior[0].centroid[0]++;  // just to make it different the first time
+        int generation = 0;
+        while (generation++ < this->MAX_FIT_STEPS && prior != this->clusters) {
+            prior = this->clusters;
+            pool.run([this](int t) { assignSlice(t); });
+            reduceAccumulators();
+            updateCentroids();
+            this->distanceCalls += partials[0].evaluations;
+            if (this->pruning)
+                this->bounds.centroidsMoved(prior, this->clusters, this->metric());
+        }
+        this->buildMembership();
+    }
+
+protected:
+    /**
+     * Per-thread cluster statistics for one generation.
+     * counts[j] = number of the thread's elements assigned to cluster j
+     * sums[j*d + dim] = sum of coordinate 'dim' over those elements
+     * evaluations = number of distances the thread evaluated
+     * Each one is aligned to a 64-byte cache line so neighbouring threads' accumulators in
+     * `partials` never share a line (no false sharing in the assignment loop).
+     */
+    struct alignas(64) Accumulator {
+        std::array<int,k> counts;
+        std::array<double,k*d> sums;
+        long evaluations;
+    };
+
+    ThreadPool pool;                    // threads that each own one slice of the elements
+    std::vector<Accumulator> partials;  // partials[t] is thread t's accumulator; partials[0] holds the merged result
+
+    /**
+     * Assign each element of thread t's slice to its closest centroid (through the bounds
+     * in the pruned mode) and accumulate the slice's per-cluster counts and sums.
+     * @param t thread number
+     */
+    virtual void assignSlice(int t) {
+        int lo, hi;
+        pool.slice(t, this->n, lo, hi);
+        Accumulator& acc = partials[t];
+        acc.counts.fill(0);
+        acc.sums.fill(0.0);
+
+        if (this->pruning) {
+            acc.evaluations = this->bounds.assign(this->elements, lo, hi, this->clusters, this->metric(),
+                                                  this->labels.data(), this->nearest.data());
+        } else {
+            acc.evaluations = static_cast<long>(hi - lo) * k;
+            for (int i = lo; i < hi; i++) {
+                this->labels[i] = this->closestCluster(this->elements[i], this->nearest[i]);
+            }
+        }
+
+        for (int i = lo; i < hi; i++) {
+            const Element& e = this->elements[i];
+            const int min = this->labels[i];
+            acc.counts[min]++;
+            for (int dim = 0; dim < d; dim++) {
+                acc.sums[min * d + dim] += e[dim];
+            }
+        }
+    }
+
+    /**
+     * Merge all the per-thread accumulators into partials[0] with a pairwise tree: in the
+     * round with a given stride, thread t (a multiple of 2*stride) adds in partials[t + stride].
+     */
+    virtual void reduceAccumulators() {
+        const int threads = pool.size();
+        for (int stride = 1; stride < threads; stride *= 2) {
+            pool.run([this, stride, threads](int t) {
+                if (t % (2 * stride) == 0 && t + stride < threads) {
+                    Accumulator& into = partials[t];
+                    const Accumulator& from = partials[t + stride];
+                    for (int j = 0; j < k; j++) {
+                        into.counts[j] += from.counts[j];
+                    }
+                    into.evaluations += from.evaluations;
+                    for (int i = 0; i < k * d; i++) {
+                        into.sums[i] += from.sums[i];
+                    }
+                }
+            });
+        }
+    }
+
+    /**
+     * Set each non-empty cluster's centroid to the mean of its elements (from partials[0]).
+     * Empty clusters keep their previous centroid.
+     */
+    virtual void updateCentroids() {
+        const Accumulator& total = partials[0];
+        for (int j = 0; j < k; j++) {
+            if (total.counts[j] > 0) {
+                for (int dim = 0; dim < d; dim++) {
+                    const double mean = total.sums[j * d + dim] / total.counts[j];
+                    this->clusters[j].centroid[dim] = static_cast<u_char>(mean);
+                }
+            }
+        }
+    }
+};
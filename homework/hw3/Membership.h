@@ -0,0 +1,77 @@
+/**
+* @file Membership.h - cluster membership lists as one compressed (CSR) index array
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#pragma once  // only process the first time it is included; ignore otherwise
+#include <cstdint>
+#include <vector>
+
+/**
+ * Members of every cluster, grouped by cluster in one array.
+ *
+ * Built from a dense label array (labels[i] is element i's cluster) by a counting sort in
+ * two passes: count each cluster's size into offsets, turn the counts into starting
+ * positions, then drop each element's index into its cluster's next slot. Cluster j's
+ * members are indices[offsets[j] .. offsets[j+1]), in increasing order.
+ *
+ * Compared to k separately grown vectors this allocates once, never reallocates, and
+ * reading one cluster after another walks a single contiguous array.
+ */
+class Membership {
+public:
+    /**
+     * Group the elements by their labels.
+     * @param labels labels[i] is the cluster of element i, in [0, k)
+     * @param n number of elements
+     * @param k number of clusters
+     */
+    void build(const std::uint32_t *labels, int n, int k) {
+        offsets.assign(k + 1, 0);
+        for (int i = 0; i < n; i++) {
+            offsets[labels[i] + 1]++;
+        }
+        for (int j = 0; j < k; j++) {
+            offsets[j + 1] += offsets[j];
+        }
+        indices.resize(n);
+        std::vector<std::uint32_t> next(offsets.begin(), offsets.end() - 1);
+        for (int i = 0; i < n; i++) {
+            indices[next[labels[i]]++] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    /** @return number of clusters */
+    int clusters() const {
+        return offsets.empty() ? 0 : static_cast<int>(offsets.size()) - 1;
+    }
+
+    /**
+     * @param j cluster number
+     * @return number of elements in cluster j
+     */
+    std::uint32_t size(int j) const {
+        return offsets[j + 1] - offsets[j];
+    }
+
+    /**
+     * @param j cluster number
+     * @return pointer to the first element index of cluster j
+     */
+    const std::uint32_t *begin(int j) const {
+        return indices.data() + offsets[j];
+    }
+
+    /**
+     * @param j cluster number
+     * @return pointer one past the last element index of cluster j
+     */
+    const std::uint32_t *end(int j) const {
+        return indices.data() + offsets[j + 1];
+    }
+
+private:
+    std::vector<std::uint32_t> offsets;  // cluster j is indices[offsets[j] .. offsets[j+1]); size k+1
+    std::vector<std::uint32_t> indices;  // element indices grouped by cluster; size n
+};
@@ -0,0 +1,52 @@
+/**
+* @file MiniBatch.h - per-centroid learning-rate update for mini-batch k-means
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#pragma once  // only process the first time it is included; ignore otherwise
+#include <cmath>
+#include <sys/types.h>
+
+/**
+ * Mini-batch k-means (Sculley, "Web-Scale K-Means Clustering") replaces each full pass
+ * with a small random batch. Every batch element assigned to centroid j pulls it toward
+ * the element with learning rate 1 / (number of elements centroid j has absorbed so far),
+ * so each centroid is the running mean of all the batch elements it was ever given and
+ * the step size shrinks per centroid as it settles.
+ *
+ * Since all elements of one batch are assigned against the same centroids, applying those
+ * per-element updates in turn equals one update from the batch's per-cluster counts and
+ * sums, which is what both the sequential and MPI engines accumulate:
+ *     center[j] = (seen[j] * center[j] + sums[j]) / (seen[j] + counts[j])
+ *
+ * Centers are kept in doubles between steps so the many small moves are not lost to byte
+ * truncation; the byte centroids used for distances are rounded from them after each step.
+ */
+namespace MiniBatch {
+
+/**
+ * Apply one batch to the centers and refresh the byte centroids.
+ * @param centers centers[j*d + dim] is centroid j's exact position (updated)
+ * @param seen seen[j] is the number of batch elements centroid j has absorbed (updated)
+ * @param counts counts[j] is the number of this batch's elements assigned to centroid j
+ * @param sums sums[j*d + dim] is the sum of coordinate dim over those elements
+ * @param clusters k clusters whose centroid members are set from the centers
+ */
+template <int k, int d, typename Count, typename Sum, typename Clusters>
+void step(double *centers, long *seen, const Count *counts, const Sum *sums, Clusters& clusters) {
+    for (int j = 0; j < k; j++) {
+        if (counts[j] == 0) {
+            continue;
+        }
+        seen[j] += counts[j];
+        const double rate = 1.0 / static_cast<double>(seen[j]);
+        for (int dim = 0; dim < d; dim++) {
+            double& c = centers[j * d + dim];
+            c += rate * (static_cast<double>(sums[j * d + dim]) - static_cast<double>(counts[j]) * c);
+            clusters[j].centroid[dim] = static_cast<u_char>(std::lround(c));
+        }
+    }
+}
+
+}  // namespace MiniBatch
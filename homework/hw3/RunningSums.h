@@ -0,0 +1,99 @@
+/**
+* @file RunningSums.h - per-cluster element sums kept across generations and updated by label changes
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#pragma once  // only process the first time it is included; ignore otherwise
+#include <array>
+#include <cstdint>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * Per-cluster counts and coordinate sums that persist from one generation to the next.
+ *
+ * The first update() after reset() adds up every element. After that only the elements
+ * whose label changed since the previous update() are touched: each is subtracted from
+ * its old cluster and added to its new one. Late generations, where few elements move,
+ * then cost a label comparison per element plus O(changed * d) instead of O(n * d).
+ * The sums are exact integers, so the mean is free of the rounding that folding elements
+ * into byte centroids one at a time (KMeans::accum) accumulates.
+ *
+ * Template parameters:
+ *  - k: number of clusters
+ *  - d: dimensionality (bytes per element)
+ */
+template <int k, int d>
+class RunningSums {
+public:
+    typedef std::array<u_char,d> Element;
+
+    /** Forget the sums; the next update() recomputes them from all elements. */
+    void reset() {
+        valid = false;
+    }
+
+    /**
+     * Bring the sums up to date with the latest labels.
+     * @param elements the elements (the same ones, in the same order, since reset())
+     * @param labels labels[i] is the cluster of elements[i]
+     * @param count number of elements
+     * @return number of elements added or moved (count after reset(), else the changed ones)
+     */
+    long update(const Element *elements, const std::uint32_t *labels, int count) {
+        if (!valid) {
+            counts.fill(0);
+            sums.assign(k * d, 0);
+            prior.assign(labels, labels + count);
+            for (int i = 0; i < count; i++) {
+                add(elements[i], labels[i], 1);
+            }
+            valid = true;
+            return count;
+        }
+        long changed = 0;
+        for (int i = 0; i < count; i++) {
+            if (labels[i] != prior[i]) {
+                add(elements[i], prior[i], -1);
+                add(elements[i], labels[i], 1);
+                prior[i] = labels[i];
+                changed++;
+            }
+        }
+        return changed;
+    }
+
+    /**
+     * @param j cluster number
+     * @return number of elements in cluster j
+     */
+    int count(int j) const {
+        return counts[j];
+    }
+
+    /**
+     * @param j cluster number
+     * @return d sums, one per coordinate, over the elements of cluster j
+     */
+    const std::int64_t *sum(int j) const {
+        return sums.data() + j * d;
+    }
+
+private:
+    bool valid = false;               // false until the first update() after reset()
+    std::array<int,k> counts{};       // counts[j] is the number of elements in cluster j
+    std::vector<std::int64_t> sums;   // sums[j*d + dim] is the sum of coordinate dim over cluster j
+    std::vector<std::uint32_t> prior; // prior[i] is the label of element i as of the previous update()
+
+    /**
+     * Add (sign 1) or remove (sign -1) one element from a cluster.
+     */
+    void add(const Element& e, std::uint32_t j, int sign) {
+        counts[j] += sign;
+        std::int64_t *s = sums.data() + j * d;
+        for (int dim = 0; dim < d; dim++) {
+            s[dim] += sign * static_cast<int>(e[dim]);
+        }
+    }
+};
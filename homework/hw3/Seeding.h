@@ -0,0 +1,164 @@
+/**
+* @file Seeding.h - k-means++ choice of initial centroids
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#pragma once  // only process the first time it is included; ignore otherwise
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <optional>
+#include <random>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * k-means++ seeding (Arthur and Vassilvitskii): the first seed is drawn in proportion to
+ * the points' weights, and each further seed in proportion to weight times the squared
+ * distance to the closest seed chosen so far. Spread-out seeds need far fewer generations
+ * than seeds sampled uniformly, which often start two centroids inside one cluster.
+ * The greedy variant here also compares a few such draws per seed.
+ *
+ * KMeans seeds from the elements themselves (every weight 1). KMeansMPI uses the same
+ * routine on ROOT as the last step of k-means||, over the candidates gathered from all
+ * ranks weighted by how many elements each attracts. KMeansDynamic seeds every k of a
+ * sweep from one run for the largest k.
+ */
+namespace Seeding {
+
+/**
+ * Random engine for one fit: from a fixed seed, so runs can be reproduced, or else from
+ * std::random_device. The stream (e.g. an MPI rank) is mixed into a fixed seed so that
+ * ranks sharing it still draw independent numbers.
+ * @param seed fixed seed, or none
+ * @param stream which of the seed's streams to use
+ * @return generator
+ */
+inline std::mt19937 makeRandom(const std::optional<unsigned>& seed, unsigned stream = 0) {
+    if (!seed) {
+        return std::mt19937{std::random_device{}()};
+    }
+    std::seed_seq sequence{*seed, stream};
+    return std::mt19937{sequence};
+}
+
+/**
+ * Draw an index in proportion to the given non-negative scores.
+ * @param scores score per index
+ * @param total sum of scores (> 0)
+ * @param random generator
+ * @return chosen index
+ */
+inline int drawProportional(const std::vector<double>& scores, double total, std::mt19937& random) {
+    std::uniform_real_distribution<double> uniform(0.0, total);
+    double target = uniform(random);
+    const int count = static_cast<int>(scores.size());
+    int last = 0;
+    for (int i = 0; i < count; i++) {
+        if (scores[i] > 0.0) {
+            last = i;
+            target -= scores[i];
+            if (target < 0.0) {
+                return i;
+            }
+        }
+    }
+    return last;  // rounding left target just above 0
+}
+
+/**
+ * Choose seeds from count points by weighted greedy k-means++: each step draws a few
+ * candidates by the k-means++ rule and keeps the one that lowers the total weighted cost
+ * the most, which avoids most of the unlucky draws that put two seeds in one cluster.
+ * If fewer than wanted points have positive weight and distinct positions, later seeds
+ * repeat earlier ones (the k-means loop then leaves the duplicates empty).
+ * The first j seeds chosen for a larger wanted are themselves a k-means++ seeding for j.
+ * @param wanted number of seeds
+ * @param weights weight per point, or nullptr for weight 1 each
+ * @param count number of points (> 0)
+ * @param squared squared distance between two points, as a callable (int i, int j) -> double
+ * @param random generator
+ * @param evaluations incremented by the number of distances evaluated
+ * @return wanted point indices
+ */
+template <typename SquaredDistance>
+std::vector<int> greedyPlusPlus(int wanted, const double *weights, int count, SquaredDistance squared,
+                                std::mt19937& random, long& evaluations) {
+    // candidates drawn per step, as in scikit-learn's default
+    const int trials = 2 + static_cast<int>(std::log(static_cast<double>(wanted)));
+    auto weight = [weights](int i) { return weights == nullptr ? 1.0 : weights[i]; };
+
+    std::vector<double> score(count);
+    double total = 0.0;
+    for (int i = 0; i < count; i++) {
+        score[i] = weight(i);
+        total += score[i];
+    }
+    std::vector<int> seeds;
+    seeds.reserve(wanted);
+    seeds.push_back(drawProportional(score, total, random));
+
+    // closest[i] = squared distance from point i to its closest seed so far
+    std::vector<double> closest(count), trial(count), best(count);
+    total = 0.0;
+    for (int i = 0; i < count; i++) {
+        closest[i] = squared(seeds[0], i);
+        score[i] = weight(i) * closest[i];
+        total += score[i];
+    }
+    evaluations += count;
+
+    while (static_cast<int>(seeds.size()) < wanted) {
+        if (total <= 0.0) {
+            seeds.push_back(seeds.front());  // every point already sits on a seed
+            continue;
+        }
+        int chosen = -1;
+        double chosenTotal = 0.0;
+        for (int t = 0; t < trials; t++) {
+            const int candidate = drawProportional(score, total, random);
+            double candidateTotal = 0.0;
+            for (int i = 0; i < count; i++) {
+                trial[i] = std::min(closest[i], squared(candidate, i));
+                candidateTotal += weight(i) * trial[i];
+            }
+            evaluations += count;
+            if (chosen < 0 || candidateTotal < chosenTotal) {
+                chosen = candidate;
+                chosenTotal = candidateTotal;
+                best.swap(trial);
+            }
+        }
+        seeds.push_back(chosen);
+        closest.swap(best);
+        total = 0.0;
+        for (int i = 0; i < count; i++) {
+            score[i] = weight(i) * closest[i];
+            total += score[i];
+        }
+    }
+    return seeds;
+}
+
+/**
+ * Choose k seeds from fixed-size elements by weighted greedy k-means++ (see greedyPlusPlus).
+ * @param points count points
+ * @param weights weight per point, or nullptr for weight 1 each
+ * @param count number of points (> 0)
+ * @param distance metric, as a callable (const Element&, const Element&) -> double
+ * @param random generator
+ * @param evaluations incremented by the number of distances evaluated
+ * @return k point indices
+ */
+template <int k, int d, typename Distance>
+std::vector<int> kMeansPlusPlus(const std::array<u_char,d> *points, const double *weights, int count,
+                                Distance distance, std::mt19937& random, long& evaluations) {
+    auto squared = [points, &distance](int i, int j) {
+        const double dist = distance(points[i], points[j]);
+        return dist * dist;
+    };
+    return greedyPlusPlus(k, weights, count, squared, random, evaluations);
+}
+
+}  // namespace Seeding
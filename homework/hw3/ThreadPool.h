@@ -0,0 +1,129 @@
+/**
+* @file ThreadPool.h - fixed set of threads that run one task on every thread at a time
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*/
+
+#pragma once  // only process the first time it is included; ignore otherwise
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Pool of threads for data-parallel loops such as one k-means generation.
+ *
+ * The pool starts its threads once and parks them between calls to run(). The thread
+ * that calls run() takes part as thread 0, so a pool of size t starts only t - 1 threads
+ * and a pool of size 1 runs everything inline.
+ *
+ * run() is meant to be called from one thread at a time (the owner of the pool).
+ */
+class ThreadPool {
+public:
+    /**
+     * Start the pool.
+     * @param nThreads number of threads including the caller of run(); defaults to every
+     *                 hardware thread on the machine
+     */
+    explicit ThreadPool(int nThreads = static_cast<int>(std::thread::hardware_concurrency()))
+        : nThreads(nThreads < 1 ? 1 : nThreads) {
+        for (int id = 1; id < this->nThreads; id++) {
+            threads.emplace_back(&ThreadPool::workLoop, this, id);
+        }
+    }
+
+    /** Wake and join all the threads. */
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t: threads) {
+            t.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** @return number of threads, including the caller of run() */
+    int size() const {
+        return nThreads;
+    }
+
+    /**
+     * Run task(t) once on every thread t in [0, size()) and return when all are done.
+     * @param task callable taking the thread number
+     */
+    void run(const std::function<void(int)>& task) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            current = &task;
+            busy = nThreads - 1;
+            round++;
+        }
+        wake.notify_all();
+
+        task(0);
+
+        std::unique_lock<std::mutex> guard(lock);
+        finished.wait(guard, [this] { return busy == 0; });
+        current = nullptr;
+    }
+
+    /**
+     * Split [0, count) into size() contiguous slices of nearly equal length.
+     * @param t thread number
+     * @param count number of items
+     * @param lo set to the first item of thread t's slice
+     * @param hi set to one past the last item of thread t's slice
+     */
+    void slice(int t, int count, int& lo, int& hi) const {
+        const int base = count / nThreads;
+        const int extra = count % nThreads;
+        lo = t * base + (t < extra ? t : extra);
+        hi = lo + base + (t < extra ? 1 : 0);
+    }
+
+private:
+    int nThreads;
+    std::vector<std::thread> threads;
+
+    std::mutex lock;
+    std::condition_variable wake;      // signals a new round (or shutdown) to the threads
+    std::condition_variable finished;  // signals the caller of run() that busy reached 0
+    const std::function<void(int)>* current = nullptr;  // task for the current round
+    long round = 0;                    // incremented once per call to run()
+    int busy = 0;                      // threads (other than the caller) still in this round
+    bool stopping = false;
+
+    /**
+     * Body of thread id: wait for each new round, run the task, report back.
+     * @param id thread number, 1 .. size()-1
+     */
+    void workLoop(int id) {
+        long seen = 0;
+        while (true) {
+            const std::function<void(int)>* task;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                wake.wait(guard, [this, seen] { return stopping || round != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = round;
+                task = current;
+            }
+
+            (*task)(id);
+
+            std::lock_guard<std::mutex> guard(lock);
+            if (--busy == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+};
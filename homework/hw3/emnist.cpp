@@ -5,23 +5,40 @@
 */
 
 #include "IdxIO.h"
+#include "IdxMPI.h"
 #include "EMNISTKMeansMPI.h"
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <iostream>
-#include <utility>
+#include <string>
 
 /**
  * Driver for EMNIST digits clustering using MPI-parallel k-means.
  *
  * This program:
- *  1) Loads an EMNIST IDX3 image file and IDX1 label file on ROOT,
+ *  1) Has every rank read its own share of an EMNIST IDX3 image file (MPI-IO) and ROOT read
+ *     the IDX1 label file,
  *  2) Runs k-means (k=10) in parallel via EMNISTKMeansMPI (built on KMeansMPI),
  *  3) Prints a short report of the converged clustering result.
  *
  * Usage:
- *   ./emnist <images> <labels>
+ *   ./emnist <images> <labels> [--prune] [--incremental] [--pipelined] [--threads <count>] [--rebalance <every>] [--batch <size> --steps <count>] [--seed <seed>]
+ *
+ * --prune skips distance evaluations with triangle-inequality bounds (same clustering).
+ * --incremental updates cluster sums only for images that changed cluster (same clustering).
+ * --pipelined overlaps each generation's reductions with assignment (same clustering).
+ * --threads runs each rank's loops on <count> threads (e.g. one rank per node with one
+ * thread per core; same clustering).
+ * --rebalance moves images from slower to faster ranks, checking every <every> generations
+ * (same clustering).
+ * --batch/--steps fit with <count> mini-batch steps of <size> sampled images each instead
+ * of full passes (--steps defaults to 100).
+ * --seed fixes the random seed, so a run (and its clustering) can be reproduced.
+ * "Same clustering" means the same labels as a plain run with the same --seed and number
+ * of ranks; kmean_modes (make run_modes) checks this for every mode.
+ * The report includes how many distances were evaluated.
  */
 
 /** K should be fixed to 10 since we have digits 0..9. */
@@ -30,61 +47,97 @@ constexpr int K = 10;
 int main(int argc, char** argv) {
     // Validate arguments.
     if (argc < 3) {
-        std::cerr << "Usage: ./emnist <images> <labels>\n";
+        std::cerr << "Usage: ./emnist <images> <labels> [--prune] [--incremental] [--pipelined] [--threads <count>] [--rebalance <every>] [--batch <size> --steps <count>] [--seed <seed>]\n";
         return 1;
     }
+    bool prune = false, incremental = false, pipelined = false;
+    int batchSize = 0, batchSteps = 100, threads = 1, rebalance = 0;
+    bool seeded = false;
+    unsigned seed = 0;
+    for (int a = 3; a < argc; a++) {
+        const std::string arg = argv[a];
+        if (arg == "--prune") {
+            prune = true;
+        } else if (arg == "--incremental") {
+            incremental = true;
+        } else if (arg == "--pipelined") {
+            pipelined = true;
+        } else if (arg == "--threads" && a + 1 < argc) {
+            threads = std::stoi(argv[++a]);
+        } else if (arg == "--rebalance" && a + 1 < argc) {
+            rebalance = std::stoi(argv[++a]);
+        } else if (arg == "--batch" && a + 1 < argc) {
+            batchSize = std::stoi(argv[++a]);
+        } else if (arg == "--steps" && a + 1 < argc) {
+            batchSteps = std::stoi(argv[++a]);
+        } else if (arg == "--seed" && a + 1 < argc) {
+            seed = static_cast<unsigned>(std::stoul(argv[++a]));
+            seeded = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
 
-    MPI_Init(nullptr, nullptr);
+    // Only the main thread makes MPI calls; the worker threads just compute.
+    int provided;
+    MPI_Init_thread(nullptr, nullptr, MPI_THREAD_FUNNELED, &provided);
     int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (threads > 1 && provided < MPI_THREAD_FUNNELED) {
+        if (rank == 0) {
+            std::cerr << "MPI does not support MPI_THREAD_FUNNELED; using 1 thread per rank\n";
+        }
+        threads = 1;
+    }
 
     EMNISTKMeansMPI<K> emnist;
+    emnist.setPruning(prune);
+    emnist.setIncremental(incremental);
+    emnist.setPipelined(pipelined);
+    emnist.setThreads(threads);
+    emnist.setRebalance(rebalance);
+    emnist.setMiniBatch(batchSize, batchSteps);
+    if (seeded) {
+        emnist.setSeed(seed);
+    }
+
+    // Every rank loads only its own images, so ROOT neither holds nor scatters the dataset.
+    auto part = read_idx3_partition(argv[1], MPI_COMM_WORLD);
+    emnist.fitPartition(part.images.data(), static_cast<int>(part.images.size()), rank);
 
     if (rank == 0) {
-        // ROOT loads the full dataset from disk.
-        auto imgs = read_idx3_images(argv[1]);
         auto labels = read_idx1_labels(argv[2]);
 
-        // move large image vector out of the container.
-        auto images = std::move(imgs.images);
-
-        // ROOT starts the k-means run.
-        emnist.fit(images.data(), static_cast<int>(images.size()));
-
         // ----- converged results -----
-        const auto &clusters = emnist.getClusters();
+        // Members of each cluster come grouped in one index array (see Membership.h).
+        const Membership &membership = emnist.getMembership();
 
         int correct = 0;
         int total = 0;
 
         // For each cluster, compute the majority digit label and report cluster size.
+        // The members that carry the majority digit are the correctly clustered ones.
         for (int c = 0; c < K; c++) {
             std::array<int, 10> freq{};  // digit frequency table for labels 0..9
 
-            for (int idx : clusters[c].elements) {
-                if (idx >= 0 && idx < static_cast<int>(labels.size())) {
-                    const int d = static_cast<int>(labels[idx]);
+            for (const std::uint32_t *idx = membership.begin(c); idx != membership.end(c); ++idx) {
+                if (*idx < labels.size()) {
+                    const int d = static_cast<int>(labels[*idx]);
                     if (0 <= d && d < 10) {
                         freq[d]++;
                     }
+                    total++;
                 }
             }
 
             const int maj = static_cast<int>(std::distance(freq.begin(), std::max_element(freq.begin(), freq.end())));
+            correct += freq[maj];
 
             std::cout << "Cluster " << c
-                      << ": size = " << clusters[c].elements.size()
+                      << ": size = " << membership.size(c)
                       << ", majority digit = " << maj
                       << std::endl;
-
-            for (int idx : clusters[c].elements) {
-                if (idx >= 0 && idx < static_cast<int>(labels.size())) {
-                    total++;
-                    if (static_cast<int>(labels[idx]) == maj) {
-                        correct++;
-                    }
-                }
-            }
         }
 
         if (total > 0) {
@@ -92,11 +145,8 @@ int main(int argc, char** argv) {
                       << (100.0 * static_cast<double>(correct) / static_cast<double>(total))
                       << "%" << std::endl;
         }
+        std::cout << "Distance evaluations: " << emnist.getDistanceCalls() << std::endl;
 
-    } else {
-        emnist.fitWork(rank);
-        MPI_Finalize();
-        return 0;
     }
 
     MPI_Finalize();
@@ -0,0 +1,147 @@
+/**
+* @file kmean_modes.cpp - checks that every KMeansMPI mode gives the plain fit's clustering
+* @author Junwen Zheng
+* @date Feb 15, 2026
+*
+* The pruned, incremental, pipelined, threaded and rebalancing modes of KMeansMPI are all
+* meant to change only how the same clustering is computed. This driver fits one data set
+* once per mode with the same random seed and compares each mode's labels with the plain
+* fit's. The data are an odd number of very noisy copies of fewer random 28x28 "digits"
+* than clusters, so k-means must split the blobs and where it ends up depends on every
+* step of the run (a mini-batch fit or another seed gives different labels). The blocked
+* EMNIST engine does the assignments, as in emnist.cpp.
+*
+* Usage:
+*   mpirun -n <p> ./kmean_modes [seed]     (p >= 3, so the partitions are uneven)
+*
+* Exits with status 1 if any mode's labels differ from the plain fit's.
+*/
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "EMNISTKMeansMPI.h"
+
+using namespace std;
+
+const int K = 10;
+const int N = 3001;        // odd, so no even number of ranks splits it evenly
+const int PROTOTYPES = 4;  // fewer than K, so clusters split overlapping blobs
+const int NOISE = 128;     // per-pixel noise in [-NOISE, NOISE]
+
+/**
+ * One combination of KMeansMPI options.
+ */
+struct Mode {
+    const char *name;
+    bool prune;
+    bool incremental;
+    bool pipelined;
+    int threads;
+    int rebalance;
+};
+
+/**
+ * Make n noisy copies of PROTOTYPES random prototype images.
+ * @param n number of images
+ * @param random generator
+ * @return the images, prototype i % PROTOTYPES for image i
+ */
+static vector<EMNISTKMeansMPI<K>::Element> makeImages(int n, mt19937& random) {
+    uniform_int_distribution<int> pixel(0, 255), noise(-NOISE, NOISE);
+    vector<EMNISTKMeansMPI<K>::Element> prototypes(PROTOTYPES), images(n);
+    for (auto& prototype: prototypes) {
+        for (u_char& p: prototype) {
+            p = static_cast<u_char>(pixel(random));
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        for (int dim = 0; dim < 784; dim++) {
+            images[i][dim] = static_cast<u_char>(clamp(prototypes[i % PROTOTYPES][dim] + noise(random), 0, 255));
+        }
+    }
+    return images;
+}
+
+/**
+ * Fit the images with one mode; every rank calls this.
+ * @param mode options to fit with
+ * @param seed random seed shared by all modes
+ * @param images the data (ROOT only)
+ * @param rank this process's MPI rank
+ * @return the labels of all images (ROOT only)
+ */
+static vector<uint32_t> fitWith(const Mode& mode, unsigned seed,
+                                vector<EMNISTKMeansMPI<K>::Element>& images, int rank) {
+    EMNISTKMeansMPI<K> kMeans;
+    kMeans.setSeed(seed);
+    kMeans.setPruning(mode.prune);
+    kMeans.setIncremental(mode.incremental);
+    kMeans.setPipelined(mode.pipelined);
+    kMeans.setThreads(mode.threads);
+    kMeans.setRebalance(mode.rebalance);
+    if (rank == 0) {
+        kMeans.fit(images.data(), static_cast<int>(images.size()));
+        return kMeans.getLabels();
+    }
+    kMeans.fitWork(rank);
+    return {};
+}
+
+int main(int argc, char **argv) {
+    const unsigned seed = argc > 1 ? static_cast<unsigned>(stoul(argv[1])) : 5600;
+
+    int provided;
+    MPI_Init_thread(nullptr, nullptr, MPI_THREAD_FUNNELED, &provided);
+    int rank, p;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    const int threads = provided >= MPI_THREAD_FUNNELED ? 3 : 1;
+
+    vector<EMNISTKMeansMPI<K>::Element> images;
+    if (rank == 0) {
+        if (p < 3) {
+            cout << "warning: run with at least 3 ranks to check uneven partitions" << endl;
+        }
+        mt19937 random(seed);
+        images = makeImages(N, random);
+    }
+
+    const Mode plain = {"plain", false, false, false, 1, 0};
+    const Mode modes[] = {
+        {"prune", true, false, false, 1, 0},
+        {"incremental", false, true, false, 1, 0},
+        {"pipelined", false, false, true, 1, 0},
+        {"pipelined prune", true, false, true, 1, 0},
+        {"threads", false, false, false, threads, 0},
+        {"rebalance", false, false, false, 1, 1},
+        {"prune incremental threads rebalance", true, true, false, threads, 1},
+    };
+
+    const vector<uint32_t> expected = fitWith(plain, seed, images, rank);
+    int failures = 0;
+    for (const Mode& mode: modes) {
+        const vector<uint32_t> labels = fitWith(mode, seed, images, rank);
+        if (rank == 0) {
+            const auto differ = mismatch(labels.begin(), labels.end(), expected.begin(), expected.end());
+            if (labels.size() != expected.size() || differ.first != labels.end()) {
+                cout << mode.name << ": FAILED, labels differ at "
+                     << (differ.first - labels.begin()) << endl;
+                failures++;
+            } else {
+                cout << mode.name << ": same labels as plain" << endl;
+            }
+        }
+    }
+    if (rank == 0) {
+        cout << N << " images, " << p << " ranks, seed " << seed << ": "
+             << (failures == 0 ? "all modes agree" : "MODES DIFFER") << endl;
+    }
+
+    MPI_Bcast(&failures, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Finalize();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file kmean_sweep.cpp - driver that sweeps k over EMNIST images with KMeansDynamic (no MPI needed)
+ * @author Junwen Zheng
+ * @date Feb 15, 2026
+ *
+ * Fits one model per k in [kmin, kmax] in a single fitMany() call and prints, per k, the
+ * generations to converge and the inertia (sum of squared distances to the centroids),
+ * whose elbow suggests a k. With --separate, the same ks are also fitted one at a time
+ * to compare the wall time against the shared passes.
+ *
+ * Usage:
+ *   ./kmean_sweep <images> [kmin] [kmax] [limit] [--separate]
+ *     kmin, kmax  range of k (default 2 to 64); kmax is clamped to the number of images
+ *     limit       use only the first limit images (default all)
+ */
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "IdxIO.h"
+#include "KMeansDynamic.h"
+
+using namespace std;
+
+/**
+ * Milliseconds since start.
+ * @param start time point to measure from
+ * @return elapsed milliseconds
+ */
+static double millisSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    vector<string> positional;
+    bool separate = false;
+    for (int a = 1; a < argc; a++) {
+        const string arg = argv[a];
+        if (arg == "--separate") {
+            separate = true;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    const char *usage = "Usage: ./kmean_sweep <images> [kmin] [kmax] [limit] [--separate]\n";
+    if (positional.empty()) {
+        cerr << usage;
+        return 1;
+    }
+    const int kmin = positional.size() > 1 ? stoi(positional[1]) : 2;
+    int kmax = positional.size() > 2 ? stoi(positional[2]) : 64;
+
+    auto imgs = read_idx3_images(positional[0]);
+    int n = static_cast<int>(imgs.images.size());
+    if (positional.size() > 3) {
+        n = min(n, stoi(positional[3]));
+    }
+
+    // there cannot be more clusters than images
+    kmax = min(kmax, n);
+    if (kmin < 1 || kmin > kmax) {
+        cerr << "Need 1 <= kmin <= kmax (kmax is clamped to " << n << " images)\n" << usage;
+        return 1;
+    }
+    const u_char *data = reinterpret_cast<const u_char *>(imgs.images.data());
+
+    vector<int> ks;
+    for (int k = kmin; k <= kmax; k++) {
+        ks.push_back(k);
+    }
+
+    KMeansDynamic kMeans(kDim);
+    auto start = chrono::steady_clock::now();
+    const vector<KMeansDynamic::Model>& models = kMeans.fitMany(data, n, ks);
+    const double batched = millisSince(start);
+
+    cout << "k,generations,inertia,mean_squared_distance" << endl;
+    for (const KMeansDynamic::Model& model: models) {
+        cout << model.k << "," << model.generations << "," << model.inertia << ","
+             << model.inertia / n << endl;
+    }
+    cout << "fitMany over " << ks.size() << " values of k, " << n << " images: " << batched << "ms" << endl;
+
+    if (separate) {
+        KMeansDynamic single(kDim);
+        start = chrono::steady_clock::now();
+        for (int k: ks) {
+            single.fit(data, n, k);
+        }
+        cout << "one fit per k: " << millisSince(start) << "ms" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file kmean_threaded_test.cpp - driver for ColorKMeansThreaded (no MPI needed)
+ * @author Junwen Zheng
+ * @date Feb 15, 2026
+ *
+ * Clusters the X11 colors with the multithreaded engine and reports the clusters, then
+ * times the engine on a larger set of random colors.
+ *
+ * Usage:
+ *   ./kmean_threaded_test [threads]
+ */
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "ColorKMeansThreaded.h"
+
+using namespace std;
+
+// How many k in "k-means"?
+const int K = 9;
+
+// size of the random color set used for timing
+const int N_RANDOM = 100000;
+
+int main(int argc, char **argv) {
+    const int threads = argc > 1 ? stoi(argv[1]) : static_cast<int>(thread::hardware_concurrency());
+
+    // Set up some data using colors from X11
+    Color *colorList;
+    string *colorLabels;
+    int nColors;
+    Color::x11Colors(&colorList, &colorLabels, &nColors);
+
+    ColorKMeansThreaded<K> kMeans(threads);
+    kMeans.fit(colorList, nColors);
+
+    // Report the result to console
+    int i = 0;
+    for (const auto& cluster: kMeans.getClusters()) {
+        Color centroid = cluster.centroid;
+        cout << endl << endl << "cluster #" << ++i << " centered at " << centroid.hex_label()
+             << ":" << endl;
+        for (int j: cluster.elements)
+            cout << colorLabels[j] << ": " << colorList[j].hex_label() << endl;
+    }
+    delete[] colorList;
+    delete[] colorLabels;
+
+    // Time a larger clustering
+    vector<Color> randomColors(N_RANDOM);
+    mt19937 random(5600);
+    uniform_int_distribution<int> byte(0, 255);
+    for (Color& c: randomColors)
+        c.set(byte(random), byte(random), byte(random));
+
+    auto start = chrono::steady_clock::now();
+    kMeans.fit(randomColors.data(), N_RANDOM);
+    auto end = chrono::steady_clock::now();
+    cout << endl << N_RANDOM << " random colors with " << threads << " threads: "
+         << chrono::duration<double,milli>(end-start).count() << "ms" << endl;
+    return 0;
+}